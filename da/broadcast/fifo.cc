@@ -1,5 +1,6 @@
 #include <da/broadcast/fifo.h>
 
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -14,25 +15,22 @@ namespace broadcast {
 namespace {
 
 // Assumes that the message has a valid minimum length.
-inline int unpackProcessId(const std::string& msg) {
-  return util::stringToInteger<uint16_t>(msg.data());
+inline int unpackProcessId(util::BytesView msg) {
+  return FifoHeader::ProcessId::load(msg.data());
 }
 
 // Assumes that the message has a valid minimum length.
-inline int unpackSn(const std::string& msg) {
-  return util::stringToInteger<int>(msg.data() + sizeof(uint16_t));
+inline int unpackSn(util::BytesView msg) {
+  return FifoHeader::Sn::load(msg.data());
 }
 
 // Assumes that the message has a valid minimum length.
-inline int unpackMessage(const std::string& msg) {
-  return util::stringToInteger<int>(msg.data() + sizeof(uint16_t) +
-                                    sizeof(int));
+inline int unpackMessage(util::BytesView msg) {
+  return util::loadBigEndian<int32_t>(msg.data() + FifoHeader::size);
 }
 
 }  // namespace
 
-const int fifo_min_length = urb_min_length + sizeof(uint16_t) + 2 * sizeof(int);
-
 UniformFIFOReliable::UniformFIFOReliable(const process::Process* local_process,
                                          std::unique_ptr<UniformReliable> urb,
                                          int processes,
@@ -49,18 +47,18 @@ UniformFIFOReliable::UniformFIFOReliable(const process::Process* local_process,
   }
 }
 
-int UniformFIFOReliable::constructIdentity(const std::string* msg) {
-  using namespace std::string_literals;
-  std::string broadcast_msg = ""s;
-  broadcast_msg += util::integerToString<uint16_t>(local_process_->getId());
-  broadcast_msg += util::integerToString<int>(lsn_++);
-  broadcast_msg += *msg;
-  return identity_manager_.assignId(broadcast_msg);
+std::string UniformFIFOReliable::constructMessage(const std::string* msg) {
+  std::string broadcast_msg(FifoHeader::size + msg->size(), '\0');
+  char* header = &broadcast_msg[0];
+  FifoHeader::ProcessId::store(header, local_process_->getId());
+  FifoHeader::Sn::store(header, lsn_++);
+  memcpy(header + FifoHeader::size, msg->data(), msg->size());
+  return broadcast_msg;
 }
 
-bool UniformFIFOReliable::deliverToURB(const std::string& msg) {
+bool UniformFIFOReliable::deliverToURB(util::BytesView msg) {
   if (!urb_->deliver(msg)) {
-    LOG("Message: ", util::stringToBinary(&msg), " was rejected by URB.");
+    LOG("Message: ", util::stringToBinary(msg), " was rejected by URB.");
     return false;
   }
   return true;
@@ -93,23 +91,24 @@ void UniformFIFOReliable::broadcast(const std::string* msg) {
     }
   }
   broadcast_msgs_ += 1;
-  int id = constructIdentity(msg);
+  const std::string broadcast_msg = constructMessage(msg);
   file_logger_->info("b {}", da::util::stringToInteger<int>(*msg));
-  urb_->broadcast(identity_manager_.getValue(id));
+  urb_->broadcast(&broadcast_msg);
 }
 
-bool UniformFIFOReliable::deliver(const std::string& msg) {
+bool UniformFIFOReliable::deliver(util::BytesView msg) {
   if (!deliverToURB(msg)) {
     return false;
   }
   // Now deliver at the level of FIFO broadcast.
-  std::string broadcast_msg(msg.data() + urb_min_length,
-                            msg.size() - urb_min_length);
-  int id = identity_manager_.assignId(broadcast_msg);
+  const util::BytesView broadcast_msg = msg.suffix(urb_min_length);
+  int id = identity_manager_.assignId(getMessageKey(msg, util::Layer::kFIFO),
+                                      broadcast_msg.toString());
   int process_id = unpackProcessId(broadcast_msg);
   int sn = unpackSn(broadcast_msg);
   if (process_id < 0 || process_id >= int(process_data_.size())) {
     LOG("Received an irrelevant process id: ", process_id + 1, ". Skipping.");
+    identity_manager_.release(id);
     return false;
   }
   process_data_[process_id]->deliver(sn, id);
@@ -142,6 +141,7 @@ void UniformFIFOReliable::ProcessData::deliver(int sn, int msg_id) {
     fifo_urb_->delivered_msgs_ += 1;
     delivered_msgs_ += 1;
     next_ += 1;
+    fifo_urb_->identity_manager_.release(it->second);
     pending_messages_.erase(it);
     it = pending_messages_.find(next_);
   }
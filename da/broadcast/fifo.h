@@ -9,14 +9,30 @@
 
 #include <da/broadcast/uniform_reliable.h>
 #include <da/process/process.h>
+#include <da/util/bytes_view.h>
+#include <da/util/identity_manager.h>
+#include <da/util/message_key.h>
 #include <da/util/util.h>
+#include <da/util/wire.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/spdlog.h>
 
 namespace da {
 namespace broadcast {
 
-extern const int fifo_min_length;
+// The header that FIFO adds in front of the message, after the URB header.
+struct FifoHeader {
+  // Denotes the process that broadcasted the message.
+  using ProcessId = util::Field<uint16_t, 0>;
+  // Denotes the FIFO sequence number the process assigned to the message.
+  using Sn = util::Field<int32_t, ProcessId::end>;
+  static constexpr int size = Sn::end;
+};
+
+// Denotes the length of a message carrying a 4-byte number, as received over
+// a link.
+constexpr int fifo_min_length =
+    urb_min_length + FifoHeader::size + sizeof(int32_t);
 
 class UniformFIFOReliable {
  public:
@@ -26,14 +42,14 @@ class UniformFIFOReliable {
 
   void broadcast(const std::string* msg);
 
-  bool deliver(const std::string& msg);
+  bool deliver(util::BytesView msg);
 
  private:
-  // Constructs and returns a unique identity for the given message.
-  int constructIdentity(const std::string* msg);
+  // Constructs and returns the message broadcasted for the given payload.
+  std::string constructMessage(const std::string* msg);
 
   // Triggers the uniform reliable's delivery.
-  bool deliverToURB(const std::string& msg);
+  bool deliverToURB(util::BytesView msg);
 
   // Uses a heursitic to decide if we should stop broadcasting messages for a
   // while.
@@ -48,8 +64,10 @@ class UniformFIFOReliable {
   // Keeps track of number of messages delivered and broadcasted.
   std::atomic<int> delivered_msgs_;
   std::atomic<int> broadcast_msgs_;
-  // Used to assign a unique identity to the messages.
-  util::IdentityManager<std::string> identity_manager_;
+  // Used to assign a unique identity to the received messages, keyed by
+  // their origin and URB sequence number.
+  util::IdentityManager<util::MessageKey, std::string, util::MessageKeyHash>
+      identity_manager_;
   class ProcessData;
   std::vector<std::unique_ptr<ProcessData>> process_data_;
 };
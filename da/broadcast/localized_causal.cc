@@ -1,6 +1,7 @@
 #include <da/broadcast/localized_causal.h>
 
 #include <algorithm>
+#include <cstring>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -21,31 +22,29 @@ namespace broadcast {
 namespace {
 
 // Assumes that the message has a valid minimum length.
-inline int unpackProcessId(const std::string& msg) {
-  return util::stringToInteger<uint16_t>(msg.data());
+inline int unpackProcessId(util::BytesView msg) {
+  return LcbHeader::ProcessId::load(msg.data());
 }
 
 // Assumes that the message has a valid minimum length.
-inline std::vector<int> unpackVectorClock(const std::string& msg,
+inline std::vector<int> unpackVectorClock(util::BytesView msg,
                                           int no_of_dependencies) {
   std::vector<int> dependencies(no_of_dependencies);
   for (int i = 0; i < no_of_dependencies; i++) {
-    dependencies[i] = util::stringToInteger<int>(msg.data() + sizeof(uint16_t) +
-                                                 i * sizeof(int));
+    dependencies[i] = LcbHeader::VectorClock::load(msg.data(), i);
   }
   return dependencies;
 }
 
-inline int unpackMessage(const std::string& msg, int no_of_dependencies) {
-  return util::stringToInteger<int>(msg.data() + sizeof(uint16_t) +
-                                    no_of_dependencies * sizeof(int));
+inline int unpackMessage(util::BytesView msg, int no_of_dependencies) {
+  return util::loadBigEndian<int32_t>(
+      msg.data() + LcbHeader::getSize(no_of_dependencies));
 }
 
 }  // namespace
 
-int lcb_min_length = urb_min_length + sizeof(uint16_t) + 2 * sizeof(int);
 // This value is overwritten in da_proc.cc
-int lcb_max_length = urb_min_length + sizeof(uint16_t) + 2 * sizeof(int);
+int lcb_max_length = lcb_min_length;
 
 UniformLocalizedCausal::UniformLocalizedCausal(
     const process::Process* local_process, std::unique_ptr<UniformReliable> urb,
@@ -60,27 +59,30 @@ UniformLocalizedCausal::UniformLocalizedCausal(
   vector_clock_.assign(processes_.size(), 0);
 }
 
-int UniformLocalizedCausal::constructIdentity(const std::string* msg) {
-  using namespace std::string_literals;
-  std::string broadcast_msg = ""s;
-  broadcast_msg += util::integerToString<uint16_t>(local_process_->getId());
-  for (const auto& dependency : local_process_->getDependencies()) {
+std::string UniformLocalizedCausal::constructMessage(
+    const std::string* msg) {
+  const auto& dependencies = local_process_->getDependencies();
+  const int header_size = LcbHeader::getSize(dependencies.size());
+  std::string broadcast_msg(header_size + msg->size(), '\0');
+  char* header = &broadcast_msg[0];
+  LcbHeader::ProcessId::store(header, local_process_->getId());
+  for (int i = 0; i < int(dependencies.size()); i++) {
     // If this is the local process we cannot increment the vector clock else
     // FIFO order will be violated. Instead encode the sequence number of the
     // broadcasted message.
-    if (dependency == local_process_->getId()) {
-      broadcast_msg += util::integerToString<int>(broadcast_msgs_);
+    if (dependencies[i] == local_process_->getId()) {
+      LcbHeader::VectorClock::store(header, i, broadcast_msgs_);
     } else {
-      broadcast_msg += util::integerToString<int>(vector_clock_[dependency]);
+      LcbHeader::VectorClock::store(header, i, vector_clock_[dependencies[i]]);
     }
   }
-  broadcast_msg += *msg;
-  return identity_manager_.assignId(broadcast_msg);
+  memcpy(header + header_size, msg->data(), msg->size());
+  return broadcast_msg;
 }
 
-bool UniformLocalizedCausal::deliverToURB(const std::string& msg) {
+bool UniformLocalizedCausal::deliverToURB(util::BytesView msg) {
   if (!urb_->deliver(msg)) {
-    LOG("Message: ", util::stringToBinary(&msg), " was rejected by URB.");
+    LOG("Message: ", util::stringToBinary(msg), " was rejected by URB.");
     return false;
   }
   return true;
@@ -107,16 +109,16 @@ void UniformLocalizedCausal::broadcast(const std::string* msg) {
       return;
     }
   }
-  int id;
+  std::string broadcast_msg;
   {
     // Need to take on the lock since we are reading vector clock while
-    // constructing identity.
+    // constructing the message.
     std::unique_lock<std::mutex> lock(mutex_);
-    id = constructIdentity(msg);
+    broadcast_msg = constructMessage(msg);
     file_logger_->info("b {}", da::util::stringToInteger<int>(*msg));
   }
   broadcast_msgs_ += 1;
-  urb_->broadcast(identity_manager_.getValue(id));
+  urb_->broadcast(&broadcast_msg);
 }
 
 void UniformLocalizedCausal::triggerDeliveries(int init_process_id) {
@@ -173,6 +175,7 @@ void UniformLocalizedCausal::triggerDeliveries(int init_process_id) {
       int no_of_dependencies = processes_[process_id]->getDependencies().size();
       file_logger_->info("d {} {}", process_id + 1,
                          unpackMessage(*msg, no_of_dependencies));
+      identity_manager_.release(msg_id);
       // Update account keeping for delivered messages if this is a local
       // message.
       if (process_id == local_process_->getId()) {
@@ -187,17 +190,18 @@ void UniformLocalizedCausal::triggerDeliveries(int init_process_id) {
   return;
 }
 
-bool UniformLocalizedCausal::deliver(const std::string& msg) {
+bool UniformLocalizedCausal::deliver(util::BytesView msg) {
   // First we need the lower level of abstraction, i.e., URB to accept the
   // message. Only then can we deliver to LCB.
   if (!deliverToURB(msg)) {
     return false;
   }
   // Recover the message broadcasted by the LCB abstraction.
-  std::string broadcast_msg(msg.data() + urb_min_length,
-                            msg.size() - urb_min_length);
+  const util::BytesView broadcast_msg = msg.suffix(urb_min_length);
   // Find the id, sender and dependencies of this message.
-  int id = identity_manager_.assignId(broadcast_msg);
+  int id = identity_manager_.assignId(
+      getMessageKey(msg, util::Layer::kLocalizedCausal),
+      broadcast_msg.toString());
   int process_id = unpackProcessId(broadcast_msg);
   const auto& dependencies = processes_[process_id]->getDependencies();
   std::vector<int> msg_vector_clock =
@@ -241,6 +245,7 @@ bool UniformLocalizedCausal::deliver(const std::string& msg) {
   // We can deliver this message!
   file_logger_->info("d {} {}", process_id + 1,
                      unpackMessage(broadcast_msg, dependencies.size()));
+  identity_manager_.release(id);
   // Update the account keeping of delivered messages for heurisitc.
   if (process_id == local_process_->getId()) {
     delivered_msgs_ += 1;
@@ -9,14 +9,40 @@
 
 #include <da/broadcast/uniform_reliable.h>
 #include <da/process/process.h>
+#include <da/util/bytes_view.h>
+#include <da/util/identity_manager.h>
+#include <da/util/message_key.h>
 #include <da/util/util.h>
+#include <da/util/wire.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/spdlog.h>
 
 namespace da {
 namespace broadcast {
 
-extern int lcb_min_length;
+// The header that LCB adds in front of the message, after the URB header.
+struct LcbHeader {
+  // Denotes the process that broadcasted the message.
+  using ProcessId = util::Field<uint16_t, 0>;
+  // Holds an entry of the vector clock per dependency of the process.
+  using VectorClock = util::ArrayField<int32_t, ProcessId::end>;
+
+  // Returns the size of the header of a process with the given number of
+  // dependencies.
+  static constexpr int getSize(int no_of_dependencies) {
+    return VectorClock::getEnd(no_of_dependencies);
+  }
+};
+
+// Returns the length of a message carrying a 4-byte number broadcasted by a
+// process with the given number of dependencies, as received over a link.
+constexpr int getLcbLength(int no_of_dependencies) {
+  return urb_min_length + LcbHeader::getSize(no_of_dependencies) +
+         sizeof(int32_t);
+}
+
+// Every process depends at least on itself.
+constexpr int lcb_min_length = getLcbLength(1);
 extern int lcb_max_length;
 
 class UniformLocalizedCausal {
@@ -29,14 +55,14 @@ class UniformLocalizedCausal {
 
   void broadcast(const std::string* msg);
 
-  bool deliver(const std::string& msg);
+  bool deliver(util::BytesView msg);
 
  private:
-  // Constructs and returns a unique identity for the given message.
-  int constructIdentity(const std::string* msg);
+  // Constructs and returns the message broadcasted for the given payload.
+  std::string constructMessage(const std::string* msg);
 
   // Triggers the uniform reliable's delivery.
-  bool deliverToURB(const std::string& msg);
+  bool deliverToURB(util::BytesView msg);
 
   // Uses a heuristic to decide if we should stop broadcasting messages for a
   // while.
@@ -51,8 +77,10 @@ class UniformLocalizedCausal {
   std::vector<std::unique_ptr<process::Process>> processes_;
   // Used to log into the file in the requried format.
   spdlog::logger* file_logger_;
-  // Used to assign a unique identity to the messages.
-  util::IdentityManager<std::string> identity_manager_;
+  // Used to assign a unique identity to the received messages, keyed by
+  // their origin and URB sequence number.
+  util::IdentityManager<util::MessageKey, std::string, util::MessageKeyHash>
+      identity_manager_;
 
   // Account keeping for heuristics.
   std::atomic<int> broadcast_msgs_;
@@ -1,5 +1,6 @@
 #include <da/broadcast/uniform_reliable.h>
 
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
@@ -11,38 +12,45 @@
 
 namespace da {
 namespace broadcast {
-namespace {
-
-// Assumes that the message has a valid minimum length.
-inline int unpackProcessId(const std::string& msg) {
-  return util::stringToInteger<uint16_t>(msg.data());
+util::MessageKey getMessageKey(util::BytesView msg, util::Layer layer) {
+  const char* header = msg.data() + link::min_length;
+  return util::MessageKey{UrbHeader::OriginId::load(header), layer,
+                          UrbHeader::Seq::load(header)};
 }
 
-}  // namespace
-
-const int urb_min_length = link::min_length;
-
 UniformReliable::UniformReliable(
     const process::Process* local_process,
     std::vector<std::unique_ptr<link::PerfectLink>> perfect_links)
-    : local_process_(local_process), perfect_links_(std::move(perfect_links)) {}
+    : local_process_(local_process),
+      perfect_links_(std::move(perfect_links)),
+      multicast_transmitter_(nullptr),
+      multicast_group_(),
+      next_link_seq_(0),
+      next_broadcast_seq_(0),
+      delivered_messages_(perfect_links_.size()) {}
 
-int UniformReliable::constructIdentity(const std::string* msg) {
-  using namespace std::string_literals;
-  std::string broadcast_msg = ""s;
-  broadcast_msg += *msg;
-  return identity_manager_.assignId(broadcast_msg);
-}
+UniformReliable::UniformReliable(
+    const process::Process* local_process,
+    std::vector<std::unique_ptr<link::PerfectLink>> perfect_links,
+    transmitter::Transmitter* multicast_transmitter,
+    const sockaddr_in& multicast_group)
+    : local_process_(local_process),
+      perfect_links_(std::move(perfect_links)),
+      multicast_transmitter_(multicast_transmitter),
+      multicast_group_(multicast_group),
+      next_link_seq_(0),
+      next_broadcast_seq_(0),
+      delivered_messages_(perfect_links_.size()) {}
 
-bool UniformReliable::deliverToPerfectLink(const std::string& msg) {
-  int process_id = unpackProcessId(msg);
+bool UniformReliable::deliverToPerfectLink(util::BytesView msg) {
+  int process_id = link::LinkHeader::SenderId::load(msg.data());
   if (process_id < 0 || process_id >= int(perfect_links_.size())) {
-    LOG("Received message: ", util::stringToBinary(&msg),
+    LOG("Received message: ", util::stringToBinary(msg),
         " from process with unknown id: ", process_id + 1);
     return false;
   }
   if (!perfect_links_[process_id]->recvMessage(msg)) {
-    LOG("Message: ", util::stringToBinary(&msg),
+    LOG("Message: ", util::stringToBinary(msg),
         " from process with id: ", process_id + 1,
         " was rejected by perfect link.");
     return false;
@@ -51,64 +59,98 @@ bool UniformReliable::deliverToPerfectLink(const std::string& msg) {
 }
 
 void UniformReliable::broadcast(const std::string* msg) {
-  int id = constructIdentity(msg);
+  const uint32_t seq = next_broadcast_seq_++;
+  std::string broadcast_msg(UrbHeader::size + msg->size(), '\0');
+  char* header = &broadcast_msg[0];
+  UrbHeader::OriginId::store(header, local_process_->getId());
+  UrbHeader::Seq::store(header, seq);
+  memcpy(header + UrbHeader::size, msg->data(), msg->size());
   {
     std::unique_lock<std::mutex> lock(mutex_);
-    if (received_messages_.find(id) == received_messages_.end()) {
-      received_messages_[id] = {};
-    }
-  }
-  const std::string* broadcast_msg = identity_manager_.getValue(id);
-  for (const auto& perfect_link : perfect_links_) {
-    perfect_link->sendMessage(broadcast_msg);
+    pending_messages_[util::MessageKey{uint16_t(local_process_->getId()),
+                                       util::Layer::kUniformReliable, seq}];
   }
+  sendToAll(&broadcast_msg);
 }
 
-void UniformReliable::rebroadcast(const std::string* msg) {
+void UniformReliable::rebroadcast(const std::string* msg) { sendToAll(msg); }
+
+void UniformReliable::sendToAll(const std::string* msg) {
+  if (multicast_transmitter_ == nullptr) {
+    for (const auto& perfect_link : perfect_links_) {
+      perfect_link->sendMessage(msg);
+    }
+    return;
+  }
+  // Every link numbers and frames the message the same way and hence, a
+  // single datagram serves all of them.
+  const uint32_t seq = next_link_seq_++;
+  std::string link_msg;
   for (const auto& perfect_link : perfect_links_) {
-    perfect_link->sendMessage(msg);
+    link_msg = perfect_link->stageMessage(msg, seq);
   }
-}
-
-bool UniformReliable::canDeliver(int id) {
-  if (received_messages_[id].size() <= perfect_links_.size() / 2) {
-    return false;
+  if (link_msg.empty()) {
+    return;
   }
-  if (delivered_messages_.find(id) != delivered_messages_.end()) {
-    return false;
+  const auto status = multicast_transmitter_->sendTo(
+      link_msg.data(), link_msg.size(), multicast_group_);
+  if (!status.ok()) {
+    LOG("Multicast of message '", util::stringToBinary(&link_msg),
+        "' failed. Status: ", status);
   }
-  return true;
 }
 
-bool UniformReliable::deliver(const std::string& msg) {
+bool UniformReliable::deliver(util::BytesView msg) {
   if (!deliverToPerfectLink(msg)) {
     return false;
   }
   // Now deliver at the level of uniform reliable broadcast.
-  int process_id = unpackProcessId(msg);
-  std::string broadcast_msg(msg.data() + link::min_length,
-                            msg.size() - link::min_length);
-  int id = identity_manager_.assignId(broadcast_msg);
-  {
-    std::unique_lock<std::mutex> lock(mutex_);
-    // Rebroadcast the message if received for the first time.
-    if (received_messages_.find(id) == received_messages_.end()) {
-      received_messages_[id] = {};
-      // We can unlock the mutex since, re-broadcasting might take some time and
-      // we have already added id into the set of received messages.
-      lock.unlock();
-      rebroadcast(&broadcast_msg);
-      // Acquire the lock once again.
-      lock.lock();
-    }
-    received_messages_[id].insert(process_id);
-    if (canDeliver(id)) {
-      delivered_messages_.insert(id);
-      LOG("URB delivered the message: ", util::stringToBinary(&broadcast_msg));
-      return true;
+  int process_id = link::LinkHeader::SenderId::load(msg.data());
+  const util::BytesView broadcast_msg = msg.suffix(link::min_length);
+  if (broadcast_msg.size() < UrbHeader::size) {
+    return false;
+  }
+  const int origin_id = UrbHeader::OriginId::load(broadcast_msg.data());
+  if (origin_id < 0 || origin_id >= int(delivered_messages_.size())) {
+    LOG("Received message: ", util::stringToBinary(broadcast_msg),
+        " from origin with unknown id: ", origin_id + 1);
+    return false;
+  }
+  const util::MessageKey key =
+      getMessageKey(msg, util::Layer::kUniformReliable);
+  const uint32_t seq = key.seq;
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (delivered_messages_[origin_id].contains(seq)) {
+    return false;
+  }
+  // Rebroadcast the message if received for the first time.
+  if (pending_messages_.find(key) == pending_messages_.end()) {
+    pending_messages_[key];
+    // We can unlock the mutex since, re-broadcasting might take some time and
+    // we have already added the message into the set of pending messages.
+    lock.unlock();
+    const std::string relay_msg = broadcast_msg.toString();
+    rebroadcast(&relay_msg);
+    // Acquire the lock once again.
+    lock.lock();
+    if (delivered_messages_[origin_id].contains(seq)) {
+      return false;
     }
   }
-  return false;
+  auto& senders = pending_messages_[key];
+  senders.insert(process_id);
+  if (senders.size() <= perfect_links_.size() / 2) {
+    return false;
+  }
+  // The later copies of the message are recognized by the window. A message
+  // too far ahead of the undelivered ones of its origin does not fit in the
+  // window and is left pending until another copy of it arrives.
+  if (!delivered_messages_[origin_id].insert(seq)) {
+    return false;
+  }
+  pending_messages_.erase(key);
+  LOG("URB delivered the message: ", util::stringToBinary(broadcast_msg));
+  return true;
 }
 
 }  // namespace broadcast
@@ -2,6 +2,7 @@
 #define __INCLUDED_DA_BROADCAST_UNIFORM_RELIABLE_H_
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -11,12 +12,32 @@
 
 #include <da/link/perfect_link.h>
 #include <da/process/process.h>
-#include <da/util/identity_manager.h>
+#include <da/transmitter/transmitter.h>
+#include <da/util/bytes_view.h>
+#include <da/util/message_key.h>
+#include <da/util/sequence_window.h>
+#include <da/util/wire.h>
 
 namespace da {
 namespace broadcast {
 
-extern const int urb_min_length;
+// The header that the URB adds in front of the payload of the layers above.
+// It follows the link header.
+struct UrbHeader {
+  // Denotes the process that broadcasted the message.
+  using OriginId = util::Field<uint16_t, 0>;
+  // Denotes the sequence number the origin assigned to the message.
+  using Seq = util::Field<uint32_t, OriginId::end>;
+  static constexpr int size = Seq::end;
+};
+
+// Denotes the offset of the payload of the layers above in a link message.
+constexpr int urb_min_length = link::min_length + UrbHeader::size;
+
+// Returns the key of a message received over a link at the given layer, made
+// of the origin and the sequence number in its URB header. Assumes that the
+// message is at least `urb_min_length` bytes long.
+util::MessageKey getMessageKey(util::BytesView msg, util::Layer layer);
 
 class UniformReliable {
  public:
@@ -24,34 +45,50 @@ class UniformReliable {
       const process::Process* local_process,
       std::vector<std::unique_ptr<link::PerfectLink>> perfect_links);
 
+  // Sends every broadcast and relay as a single datagram to the multicast
+  // group instead of once per process. The perfect links still retransmit to
+  // the processes that do not acknowledge it.
+  UniformReliable(
+      const process::Process* local_process,
+      std::vector<std::unique_ptr<link::PerfectLink>> perfect_links,
+      transmitter::Transmitter* multicast_transmitter,
+      const sockaddr_in& multicast_group);
+
   void broadcast(const std::string* msg);
 
-  bool deliver(const std::string& msg);
+  bool deliver(util::BytesView msg);
 
  private:
-  // Constructs and returns a unique identity for the given message.
-  int constructIdentity(const std::string* msg);
-
   // Triggers the perfect link delivery.
-  bool deliverToPerfectLink(const std::string& msg);
+  bool deliverToPerfectLink(util::BytesView msg);
 
   // Rebroadcasts the message received from someone.
   void rebroadcast(const std::string* msg);
 
-  // Returns if the given message identifier is eligible to be delivered.
-  bool canDeliver(int id);
+  // Sends the message to every process over the perfect links.
+  void sendToAll(const std::string* msg);
 
   const process::Process* local_process_;
   std::vector<std::unique_ptr<link::PerfectLink>> perfect_links_;
+  // Unset unless the messages are multicast.
+  transmitter::Transmitter* multicast_transmitter_;
+  sockaddr_in multicast_group_;
+  // Denotes the sequence number of the next multicast message, which is the
+  // same on every link.
+  std::atomic<uint32_t> next_link_seq_;
+  // Denotes the sequence number of the next message broadcasted by the local
+  // process.
+  std::atomic<uint32_t> next_broadcast_seq_;
   std::mutex mutex_;
-  // Used to assign a unique identity to the messages.
-  util::IdentityManager<std::string> identity_manager_;
-  // A map from messages that have been received to the set of process_ids from
-  // who the same message was received. Note that the key set of this map
-  // denotes the set of pending messages too.
-  std::unordered_map<int, std::unordered_set<int>> received_messages_;
-  // Denotes the messages that have been delivered.
-  std::unordered_set<int> delivered_messages_;
+  // A map from the messages that have been received but not delivered yet,
+  // keyed by their origin and sequence number, to the set of process_ids from
+  // who the same message was received.
+  std::unordered_map<util::MessageKey, std::unordered_set<int>,
+                     util::MessageKeyHash>
+      pending_messages_;
+  // Denotes the sequence numbers of the messages that have been delivered per
+  // origin.
+  std::vector<util::SequenceWindow> delivered_messages_;
 };
 
 }  // namespace broadcast
@@ -1,11 +1,15 @@
 #include <da/da_proc.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <functional>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include <netinet/in.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,7 +22,13 @@
 #include <da/init/parser.h>
 #include <da/link/perfect_link.h>
 #include <da/receiver/receiver.h>
+#include <da/receiver/shared_memory_receiver.h>
+#include <da/shm/shared_memory.h>
+#include <da/socket/socket.h>
 #include <da/socket/udp_socket.h>
+#include <da/transmitter/frame.h>
+#include <da/transmitter/transmitter.h>
+#include <da/util/buffer_pool.h>
 #include <da/util/logging.h>
 #include <da/util/statusor.h>
 #include <da/util/util.h>
@@ -33,13 +43,32 @@ std::atomic<bool> kCanStop{false};
 
 namespace {
 
+// Denotes the default sizes of the sockets' kernel buffers in bytes.
+const int default_recv_buffer_size = 8 * 1024 * 1024;
+const int default_send_buffer_size = 2 * 1024 * 1024;
+// Denotes the number of buffers the pool of received messages grows by.
+const int buffer_pool_slab = 4096;
+// Denotes the largest datagram the messages are packed into. Fills an Ethernet
+// MTU by default and a jumbo frame at most.
+const int default_max_frame_size = 1472;
+const int max_frame_size_limit = 8972;
+// Denotes the size of the ring every local process publishes into in bytes.
+const int shm_ring_capacity = 256 * 1024;
+
 std::atomic<bool> can_start{false};
 std::shared_ptr<spdlog::logger> file_logger;
+// Outlives the executor which might still hold received messages.
+std::unique_ptr<da::util::BufferPool> buffer_pool;
 std::unique_ptr<da::executor::Executor> executor;
 std::unique_ptr<da::executor::Scheduler> scheduler;
-std::unique_ptr<da::receiver::Receiver> receiver;
-std::unique_ptr<std::thread> receiver_thread;
-std::unique_ptr<da::socket::UDPSocket> sock;
+std::vector<std::unique_ptr<da::receiver::Receiver>> receivers;
+std::vector<std::thread> receiver_threads;
+std::unique_ptr<da::shm::Inbox> inbox;
+std::unique_ptr<da::receiver::SharedMemoryReceiver> shm_receiver;
+std::unique_ptr<std::thread> shm_receiver_thread;
+std::unique_ptr<da::transmitter::Transmitter> transmitter;
+std::unique_ptr<std::thread> transmitter_thread;
+std::vector<std::unique_ptr<da::socket::UDPSocket>> sockets;
 
 void registerUsrHandlers() {
   // Register a function to toggle the can_start when SIGUSR{1,2} is received.
@@ -68,18 +97,66 @@ void exitThreads() {
     LOG("Stopping the scheduler.");
     scheduler->waitForCompletion();
   }
-  // Stop the receiver.
-  if (receiver != nullptr) {
+  // Stop the receivers.
+  for (auto& receiver : receivers) {
     LOG("Stopping the receiver.");
     receiver->stop();
   }
-  // Stop the receiver thread.
-  if (receiver_thread != nullptr && receiver_thread->joinable()) {
-    LOG("Stopping the receiver thread.");
-    receiver_thread->join();
+  // Stop the receiver threads.
+  for (auto& receiver_thread : receiver_threads) {
+    if (receiver_thread.joinable()) {
+      LOG("Stopping the receiver thread.");
+      receiver_thread.join();
+    }
+  }
+  // Stop the shared memory receiver.
+  if (shm_receiver != nullptr) {
+    LOG("Stopping the shared memory receiver.");
+    shm_receiver->stop();
+  }
+  // Stop the shared memory receiver thread.
+  if (shm_receiver_thread != nullptr && shm_receiver_thread->joinable()) {
+    LOG("Stopping the shared memory receiver thread.");
+    shm_receiver_thread->join();
+  }
+  // Let the local processes know that nobody drains the inbox anymore.
+  if (inbox != nullptr) {
+    LOG("Closing the inbox.");
+    shm_receiver = nullptr;
+    inbox = nullptr;
+  }
+  // Stop the transmitter.
+  if (transmitter != nullptr) {
+    LOG("Stopping the transmitter.");
+    transmitter->stop();
   }
-  // Disconnect the socket.
-  if (sock != nullptr) {
+  // Stop the transmitter thread.
+  if (transmitter_thread != nullptr && transmitter_thread->joinable()) {
+    LOG("Stopping the transmitter thread.");
+    transmitter_thread->join();
+  }
+  // Report the sockets' buffers and drops even if logging is compiled out, so
+  // that the buffer sizes can be tuned.
+  for (std::size_t i = 0; i < sockets.size(); i++) {
+    const auto recv_buffer_size_or = sockets[i]->getReceiveBufferSize();
+    const auto send_buffer_size_or = sockets[i]->getSendBufferSize();
+    std::cerr << "Socket " << i << ": receive buffer: ";
+    if (recv_buffer_size_or.ok()) {
+      std::cerr << recv_buffer_size_or.value();
+    } else {
+      std::cerr << recv_buffer_size_or.status();
+    }
+    std::cerr << " send buffer: ";
+    if (send_buffer_size_or.ok()) {
+      std::cerr << send_buffer_size_or.value();
+    } else {
+      std::cerr << send_buffer_size_or.status();
+    }
+    std::cerr << " dropped datagrams: " << sockets[i]->getDropCount()
+              << std::endl;
+  }
+  // Disconnect the sockets.
+  for (auto& sock : sockets) {
     LOG("Disconnecting the socket.");
     const auto status = sock->disconnect();
     if (!status.ok()) {
@@ -93,6 +170,46 @@ void exitThreads() {
   }
 }
 
+// Opens a socket that receives the datagrams sent to the multicast group given
+// as `ip:port` through the interface with the given address and resolves the
+// group's address.
+da::util::Status openMulticastSocket(
+    const std::string& group, const std::string& interface_addr,
+    struct timeval tv, std::unique_ptr<da::socket::UDPSocket>& sock,
+    sockaddr_in& group_addr) {
+  const auto pos = group.find(':');
+  if (pos == std::string::npos) {
+    return da::util::Status(da::util::StatusCode::kInvalidArgument,
+                            "Multicast group must be given as ip:port");
+  }
+  const std::string group_ip = group.substr(0, pos);
+  const int group_port = atoi(group.c_str() + pos + 1);
+  auto status = da::socket::fillAddr(group_ip, group_port, group_addr);
+  if (!status.ok()) {
+    return status;
+  }
+  if (!IN_MULTICAST(ntohl(group_addr.sin_addr.s_addr))) {
+    return da::util::Status(da::util::StatusCode::kInvalidArgument,
+                            "Address is not a multicast group");
+  }
+  // Every process on the host binds to the group's port.
+  try {
+    sock = std::make_unique<da::socket::UDPSocket>(group_ip, group_port, tv,
+                                                   true);
+  } catch (const da::util::RuntimeStatusError& error) {
+    return error.status();
+  }
+  return sock->joinGroup(group_ip, interface_addr);
+}
+
+// Returns whether both the processes run on the same host.
+bool isLocal(const da::process::Process& local_process,
+             const da::process::Process& process) {
+  return process.getIPAddr() == local_process.getIPAddr() ||
+         ntohl(process.getAddr().sin_addr.s_addr) >> IN_CLASSA_NSHIFT ==
+             IN_LOOPBACKNET;
+}
+
 void registerTermAndIntHandlers() {
   signal(SIGTERM, exitHandler);
   signal(SIGINT, exitHandler);
@@ -119,8 +236,8 @@ int main(int argc, char** argv) {
   for (const auto& process : processes) {
     da::broadcast::lcb_max_length =
         std::max(da::broadcast::lcb_max_length,
-                 int(da::broadcast::urb_min_length + sizeof(uint16_t) +
-                     (1 + process->getDependencies().size()) * sizeof(int)));
+                 da::broadcast::getLcbLength(
+                     process->getDependencies().size()));
     if (!process->isCurrent()) {
       continue;
     }
@@ -137,34 +254,189 @@ int main(int argc, char** argv) {
       "da_proc_" + std::to_string(current_process->getId() + 1) + ".out", true);
   file_logger->set_pattern("%v");
   // Create executors and a UDP socket for current process.
+  // Messages are sharded by their origin and hence, more shards than processes
+  // would never be used.
   int num_threads = std::thread::hardware_concurrency() * 5;
+  num_threads = (num_threads + processes.size() - 1) / processes.size();
+  num_threads = std::min<int>(num_threads, processes.size());
   executor = std::make_unique<da::executor::Executor>(
-      (num_threads + processes.size() - 1) / (processes.size()));
-  scheduler = std::make_unique<da::executor::Scheduler>(1);
-  // Create a socket with receive timeout of 1000 micro-seconds.
+      num_threads, da::executor::Executor::Mode::kSharded);
+  // Retransmission timeouts never go below 1 milli-second and acknowledgements
+  // are held back for 1 milli-second and hence, a timing wheel with a tick of
+  // 1 milli-second is precise enough.
+  scheduler = std::make_unique<da::executor::Scheduler>(
+      1, std::chrono::microseconds(1000));
+  // Receive through as many sockets as asked to at startup. The sockets share
+  // the port and each of them gets a receiver thread of its own. More sockets
+  // than processes would never be used.
+  int num_sockets = 1;
+  if (const char* value = getenv("DA_RECEIVER_SOCKETS")) {
+    num_sockets = std::max(1, std::min<int>(atoi(value), processes.size()));
+  }
+  // Create the sockets with receive timeout of 1000 micro-seconds.
   struct timeval tv;
   tv.tv_sec = 1;
   tv.tv_usec = 0;
-  sock = std::make_unique<da::socket::UDPSocket>(
-      current_process->getIPAddr(), current_process->getPort(), tv);
+  sockets.reserve(num_sockets + 1);
+  for (int i = 0; i < num_sockets; i++) {
+    sockets.emplace_back(std::make_unique<da::socket::UDPSocket>(
+        current_process->getIPAddr(), current_process->getPort(), tv,
+        num_sockets > 1));
+  }
+  // Multicast the broadcasts to the group given at startup, if any. The
+  // group's datagrams are received through one more socket.
+  sockaddr_in multicast_group;
+  bool is_multicast = false;
+  if (const char* value = getenv("DA_MULTICAST_GROUP")) {
+    std::unique_ptr<da::socket::UDPSocket> multicast_sock;
+    auto status =
+        openMulticastSocket(value, current_process->getIPAddr(), tv,
+                            multicast_sock, multicast_group);
+    if (status.ok()) {
+      status =
+          sockets[0]->setMulticastInterface(current_process->getIPAddr());
+    }
+    if (status.ok()) {
+      sockets.emplace_back(std::move(multicast_sock));
+      is_multicast = true;
+    } else {
+      LOG("Falling back to unicast. Status: ", status);
+    }
+  }
+  // Size the kernel buffers so that bursts are not dropped, unless asked for
+  // other sizes at startup, and count the drops.
+  int recv_buffer_size = default_recv_buffer_size;
+  if (const char* value = getenv("DA_SOCKET_RCVBUF")) {
+    recv_buffer_size = atoi(value);
+  }
+  int send_buffer_size = default_send_buffer_size;
+  if (const char* value = getenv("DA_SOCKET_SNDBUF")) {
+    send_buffer_size = atoi(value);
+  }
+  for (auto& sock : sockets) {
+    auto status = sock->setReceiveBufferSize(recv_buffer_size);
+    if (!status.ok()) {
+      LOG("Failed to size the receive buffer. Status: ", status);
+    }
+    status = sock->setSendBufferSize(send_buffer_size);
+    if (!status.ok()) {
+      LOG("Failed to size the send buffer. Status: ", status);
+    }
+    status = sock->enableDropCounting();
+    if (!status.ok()) {
+      LOG("Failed to count the drops. Status: ", status);
+    }
+  }
+  // Keep all the datagrams of a sender on the same socket. Every message of a
+  // frame comes from the same sender, so the sender id of the first one that
+  // follows its length prefix stands for the whole datagram. The kernel
+  // spreads the datagrams by a hash of their addresses if this fails.
+  if (num_sockets > 1) {
+    const auto status = sockets[0]->steerReusePortGroup(
+        num_sockets, da::transmitter::frame_header_size +
+                         da::link::LinkHeader::SenderId::offset);
+    if (!status.ok()) {
+      LOG("Falling back to the kernel's steering. Status: ", status);
+    }
+  }
+  // Opt into io_uring for the sockets if asked to at startup.
+  if (getenv("DA_IO_URING") != nullptr) {
+    for (auto& sock : sockets) {
+      const auto status = sock->enableIoUring();
+      if (!status.ok()) {
+        LOG("Falling back to system calls since io_uring is unavailable. "
+            "Status: ",
+            status);
+      }
+    }
+  }
+  // Launch a thread that will be sending the packets in batches, packing the
+  // messages into datagrams of a size that might be asked for at startup.
+  int max_frame_size = default_max_frame_size;
+  if (const char* value = getenv("DA_MAX_FRAME_SIZE")) {
+    max_frame_size = std::min(std::max(atoi(value), 1), max_frame_size_limit);
+  }
+  // Send to every peer over a connected socket of its own if asked to at
+  // startup.
+  const bool connect_peers = getenv("DA_CONNECT_PEERS") != nullptr;
+  transmitter = std::make_unique<da::transmitter::Transmitter>(
+      sockets[0].get(), connect_peers, max_frame_size);
+  transmitter_thread =
+      std::make_unique<std::thread>([]() { (*transmitter)(); });
+  // Exchange the datagrams with the processes on the same host through shared
+  // memory if asked to at startup.
+  if (getenv("DA_SHARED_MEMORY") != nullptr) {
+    inbox = std::make_unique<da::shm::Inbox>(da::shm::getSegmentName(
+        current_process->getIPAddr(), current_process->getPort()));
+    // The rings are indexed by the ids of the senders.
+    int max_id = 0;
+    for (const auto& process : processes) {
+      max_id = std::max(max_id, process->getId());
+    }
+    const auto status = inbox->init(max_id + 1, shm_ring_capacity);
+    if (status.ok()) {
+      for (const auto& process : processes) {
+        if (!isLocal(*current_process, *process)) {
+          continue;
+        }
+        transmitter->addSharedMemoryPeer(
+            process->getAddr(),
+            std::make_unique<da::shm::Outbox>(
+                da::shm::getSegmentName(process->getIPAddr(),
+                                        process->getPort()),
+                current_process->getId()));
+      }
+    } else {
+      LOG("Falling back to sockets for the local processes. Status: ",
+          status);
+      inbox = nullptr;
+    }
+  }
   // Create a list of perfect links to all the processes.
   std::vector<std::unique_ptr<da::link::PerfectLink>> perfect_links;
   perfect_links.reserve(processes.size());
   for (const auto& process : processes) {
     perfect_links.emplace_back(std::make_unique<da::link::PerfectLink>(
-        scheduler.get(), sock.get(), current_process, process.get()));
+        scheduler.get(), transmitter.get(), current_process, process.get()));
   }
   // Create a uniform reliable broadcast object.
-  auto urb = std::make_unique<da::broadcast::UniformReliable>(
-      current_process, std::move(perfect_links));
+  std::unique_ptr<da::broadcast::UniformReliable> urb;
+  if (is_multicast) {
+    urb = std::make_unique<da::broadcast::UniformReliable>(
+        current_process, std::move(perfect_links), transmitter.get(),
+        multicast_group);
+  } else {
+    urb = std::make_unique<da::broadcast::UniformReliable>(
+        current_process, std::move(perfect_links));
+  }
   // Create a uniform localized causal reliable broadcast object.
   auto lc_urb = std::make_unique<da::broadcast::UniformLocalizedCausal>(
       current_process, std::move(urb), std::move(processes), file_logger.get());
-  // Launch a thread that will be receiving packets.
-  receiver =
-      std::make_unique<da::receiver::Receiver>(executor.get(), sock.get());
-  receiver_thread =
-      std::make_unique<std::thread>([&lc_urb]() { (*receiver)(lc_urb.get()); });
+  // Launch a thread per socket that will be receiving packets into buffers
+  // large enough to hold the largest frame. A message larger than a frame is
+  // sent in a frame of its own.
+  buffer_pool = std::make_unique<da::util::BufferPool>(
+      std::max(max_frame_size, da::broadcast::lcb_max_length +
+                                   da::transmitter::frame_header_size),
+      buffer_pool_slab);
+  receivers.reserve(sockets.size());
+  receiver_threads.reserve(sockets.size());
+  for (auto& sock : sockets) {
+    receivers.emplace_back(
+        std::make_unique<da::receiver::Receiver>(executor.get(), sock.get(),
+                                                 buffer_pool.get()));
+  }
+  for (auto& receiver : receivers) {
+    auto receiver_ptr = receiver.get();
+    receiver_threads.emplace_back(
+        [receiver_ptr, &lc_urb]() { (*receiver_ptr)(lc_urb.get()); });
+  }
+  if (inbox != nullptr) {
+    shm_receiver = std::make_unique<da::receiver::SharedMemoryReceiver>(
+        executor.get(), inbox.get(), buffer_pool.get());
+    shm_receiver_thread = std::make_unique<std::thread>(
+        [&lc_urb]() { (*shm_receiver)(lc_urb.get()); });
+  }
   // Loop until SIGUSR2 hasn't received or an exit is called.
   while (!can_start && !da::kCanStop) {
     da::util::nanosleep(1000);
@@ -4,11 +4,43 @@
 
 namespace da {
 namespace executor {
+namespace {
+
+// Denotes the executor and the worker id of the current thread (if any).
+thread_local const Executor* current_executor = nullptr;
+thread_local int current_worker_id = -1;
+
+}  // namespace
 
 Executor::Executor() : Executor(std::thread::hardware_concurrency()) {}
 
 Executor::Executor(int no_of_threads)
-    : alive_(true), workers_(std::vector<std::thread>(no_of_threads)) {
+    : Executor(no_of_threads, Mode::kSharedQueue) {}
+
+Executor::Executor(int no_of_threads, Mode mode)
+    : Executor(no_of_threads, mode, 0) {}
+
+Executor::Executor(int no_of_threads, Mode mode, int queue_capacity)
+    : mode_(mode),
+      alive_(true),
+      workers_(std::vector<std::thread>(no_of_threads)),
+      queue_(queue_capacity),
+      pending_(0),
+      idle_workers_(0),
+      next_deque_(0) {
+  if (mode_ == Mode::kWorkStealing) {
+    deques_.reserve(no_of_threads);
+    for (int id = 0; id < no_of_threads; id++) {
+      deques_.emplace_back(
+          std::make_unique<WorkStealingDeque<InlineTask>>());
+    }
+  }
+  if (mode_ == Mode::kSharded) {
+    shards_.reserve(no_of_threads);
+    for (int id = 0; id < no_of_threads; id++) {
+      shards_.emplace_back(std::make_unique<Shard>(queue_capacity));
+    }
+  }
   for (int id = 0; id < int(workers_.size()); id++) {
     workers_[id] = std::thread(Worker(id, this));
   }
@@ -20,9 +52,19 @@ Executor::~Executor() {
   }
 }
 
-void Executor::waitForCompletion() {
+void Executor::stop() {
   alive_ = false;
   queue_.stop();
+  for (const auto& deque : deques_) {
+    deque->stop();
+  }
+  for (const auto& shard : shards_) {
+    shard->stop();
+  }
+}
+
+void Executor::waitForCompletion() {
+  stop();
   {
     std::unique_lock<std::mutex> lock(mutex_);
     cond_var_.notify_all();
@@ -34,28 +76,142 @@ void Executor::waitForCompletion() {
   }
 }
 
+void Executor::submit(InlineTask f) {
+  if (mode_ == Mode::kSharded) {
+    // Functions without a key can run anywhere.
+    submit(next_deque_++, std::move(f));
+    return;
+  }
+  if (mode_ == Mode::kSharedQueue) {
+    // A bounded queue refuses the function when full. Let the workers catch up.
+    while (!queue_.enqueue(std::move(f))) {
+      if (!isAlive()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+  } else {
+    // Workers keep the functions they add for themselves. Everyone else
+    // spreads them in a round robin fashion.
+    int id = current_worker_id;
+    if (current_executor != this) {
+      id = next_deque_++ % deques_.size();
+    }
+    deques_[id]->enqueue(std::move(f));
+  }
+  pending_ += 1;
+  // Only take the lock if there is someone to be woken up. A worker increments
+  // `idle_workers_` before checking `pending_` and hence, cannot miss this.
+  if (idle_workers_ > 0) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.notify_one();
+  }
+}
+
+void Executor::submit(unsigned int key, InlineTask f) {
+  if (mode_ != Mode::kSharded) {
+    submit(std::move(f));
+    return;
+  }
+  shards_[key % shards_.size()]->submit(std::move(f));
+}
+
+Executor::Shard::Shard(int queue_capacity)
+    : queue_(queue_capacity), pending_(0), idle_(false) {}
+
+void Executor::Shard::stop() {
+  queue_.stop();
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_var_.notify_all();
+}
+
+void Executor::Shard::submit(InlineTask f) {
+  // A bounded queue refuses the function when full. Let the owner catch up.
+  while (!queue_.enqueue(std::move(f))) {
+    if (queue_.isStopped()) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+  pending_ += 1;
+  // The owner sets `idle_` before checking `pending_` and hence, cannot miss
+  // this.
+  if (idle_) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.notify_one();
+  }
+}
+
+void Executor::Shard::run(const Executor* executor) {
+  while (executor->isAlive()) {
+    InlineTask f;
+    if (queue_.dequeue(f)) {
+      pending_ -= 1;
+      f();
+      continue;
+    }
+    // Park until some function is added to this shard.
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_ = true;
+    cond_var_.wait(lock,
+                   [&] { return !executor->isAlive() || pending_ > 0; });
+    idle_ = false;
+  }
+}
+
 Executor::Worker::Worker(int id, Executor* executor)
     : id_(id), executor_(executor) {}
 
 void Executor::Worker::operator()() {
+  current_executor = executor_;
+  current_worker_id = id_;
+  if (executor_->mode_ == Mode::kSharded) {
+    executor_->shards_[id_]->run(executor_);
+    return;
+  }
   while (executor_->isAlive()) {
-    std::function<void()> f;
-    {
-      std::unique_lock<std::mutex> lock(executor_->mutex_);
-      if (executor_->queue_.empty()) {
-        executor_->cond_var_.wait(lock, [this] {
-          return !executor_->isAlive() || !executor_->queue_.empty();
-        });
-      }
-      if (!executor_->isAlive()) {
-        return;
-      }
-      if (!executor_->queue_.dequeue(f)) {
-        continue;
-      }
+    InlineTask f;
+    if (findTask(f)) {
+      executor_->pending_ -= 1;
+      f();
+      continue;
+    }
+    // Park until some function is added.
+    std::unique_lock<std::mutex> lock(executor_->mutex_);
+    executor_->idle_workers_ += 1;
+    executor_->cond_var_.wait(lock, [this] {
+      return !executor_->isAlive() || executor_->pending_ > 0;
+    });
+    executor_->idle_workers_ -= 1;
+  }
+}
+
+bool Executor::Worker::findTask(InlineTask& f) {
+  if (executor_->mode_ == Mode::kSharedQueue) {
+    return executor_->queue_.dequeue(f);
+  }
+  if (executor_->deques_[id_]->dequeue(f)) {
+    return true;
+  }
+  return steal(f);
+}
+
+bool Executor::Worker::steal(InlineTask& f) {
+  const int no_of_deques = executor_->deques_.size();
+  std::vector<InlineTask> stolen;
+  // Start from the next worker so that the victims are spread out.
+  for (int i = 1; i < no_of_deques; i++) {
+    const int victim = (id_ + i) % no_of_deques;
+    if (!executor_->deques_[victim]->stealHalf(stolen)) {
+      continue;
     }
-    f();
+    // Execute the oldest stolen function and keep the rest.
+    f = std::move(stolen.front());
+    stolen.erase(stolen.begin());
+    executor_->deques_[id_]->enqueueAll(stolen);
+    return true;
   }
+  return false;
 }
 
 }  // namespace executor
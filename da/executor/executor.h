@@ -4,22 +4,46 @@
 #include <atomic>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <utility>
 #include <vector>
 
+#include <da/executor/inline_task.h>
 #include <da/executor/thread_safe_queue.h>
+#include <da/executor/work_stealing_deque.h>
 
 namespace da {
 namespace executor {
 
 class Executor {
  public:
+  // Decides how the added functions are distributed among the workers.
+  enum class Mode {
+    // All the workers dequeue from a single shared queue. The queue can be
+    // backed by a lock-free bounded ring by providing a capacity.
+    kSharedQueue,
+    // Every worker owns a deque and steals half of another worker's deque when
+    // its own runs dry. Idle workers are parked until new work arrives.
+    kWorkStealing,
+    // Every worker owns a shard that only it consumes. Functions added with
+    // the same key land on the same shard and hence, run one after another in
+    // the order they were added.
+    kSharded,
+  };
+
   Executor();
 
   Executor(int no_of_threads);
 
+  Executor(int no_of_threads, Mode mode);
+
+  // A positive `queue_capacity` makes the shared queue (or every shard's queue)
+  // a lock-free ring of the given capacity. Adding to a full ring waits until a
+  // slot frees up.
+  Executor(int no_of_threads, Mode mode, int queue_capacity);
+
   ~Executor();
 
   // Delete the copy constructor.
@@ -33,10 +57,7 @@ class Executor {
 
   bool isAlive() const { return alive_; }
 
-  void stop() {
-    alive_ = false;
-    queue_.stop();
-  }
+  void stop();
 
   void waitForCompletion();
 
@@ -44,14 +65,64 @@ class Executor {
   template <typename Function, typename... Args>
   auto add(Function&& f, Args&&... args) -> std::future<decltype(f(args...))>;
 
+  // Adds the function to be executed as soon as possible without a way to
+  // wait for its result. Unlike `add` this does not allocate as long as the
+  // callable fits in an `InlineTask`.
+  template <typename Function>
+  void post(Function&& f);
+
+  // Same as above but in the sharded mode all the functions with the same key
+  // are executed by the same worker in the order they were posted. The key is
+  // ignored in the other modes.
+  template <typename Function>
+  void post(unsigned int key, Function&& f);
+
  private:
+  class Shard;
   class Worker;
 
+  // Enqueues the function according to the mode and wakes up a worker.
+  void submit(InlineTask f);
+
+  // Enqueues the function on the shard owning the key.
+  void submit(unsigned int key, InlineTask f);
+
+  const Mode mode_;
   std::atomic<bool> alive_;
   std::vector<std::thread> workers_;
-  ThreadSafeQueue<std::function<void()>> queue_;
+  ThreadSafeQueue<InlineTask> queue_;
   std::mutex mutex_;
   std::condition_variable cond_var_;
+  // Used only in the work stealing mode.
+  std::vector<std::unique_ptr<WorkStealingDeque<InlineTask>>> deques_;
+  // Used only in the sharded mode.
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // Denotes the number of functions waiting to be executed.
+  std::atomic<int> pending_;
+  // Denotes the number of workers parked on the condition variable.
+  std::atomic<int> idle_workers_;
+  // Used to distribute functions added by non worker threads.
+  std::atomic<unsigned int> next_deque_;
+};
+
+class Executor::Shard {
+ public:
+  Shard(int queue_capacity);
+
+  void stop();
+
+  // Enqueues the function and wakes up the owner if it is parked.
+  void submit(InlineTask f);
+
+  // Executes the functions of this shard until the executor is stopped.
+  void run(const Executor* executor);
+
+ private:
+  ThreadSafeQueue<InlineTask> queue_;
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+  std::atomic<int> pending_;
+  std::atomic<bool> idle_;
 };
 
 class Executor::Worker {
@@ -61,6 +132,13 @@ class Executor::Worker {
   void operator()();
 
  private:
+  // Finds a function to execute. In the work stealing mode the own deque is
+  // looked at first and then the other workers' deques.
+  bool findTask(InlineTask& f);
+
+  // Moves half of some other worker's deque into this worker's deque.
+  bool steal(InlineTask& f);
+
   const int id_;
   Executor* executor_;
 };
@@ -75,17 +153,21 @@ auto Executor::add(Function&& f, Args&&... args)
   auto task =
       std::make_shared<std::packaged_task<decltype(f(args...))()>>(func);
   // Correct the type and enqueue it to be executed.
-  std::function<void()> ret_void_func = [task]() { (*task)(); };
-  queue_.enqueue(ret_void_func);
-  // Wake up a thread to execute the function (if it was waiting).
-  {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cond_var_.notify_one();
-  }
+  submit([task]() { (*task)(); });
   // Return a future if there was a return type expected.
   return task->get_future();
 }
 
+template <typename Function>
+void Executor::post(Function&& f) {
+  submit(InlineTask(std::forward<Function>(f)));
+}
+
+template <typename Function>
+void Executor::post(unsigned int key, Function&& f) {
+  submit(key, InlineTask(std::forward<Function>(f)));
+}
+
 }  // namespace executor
 }  // namespace da
 
@@ -0,0 +1,158 @@
+#ifndef __INCLUDED_DA_EXECUTOR_INLINE_TASK_H_
+#define __INCLUDED_DA_EXECUTOR_INLINE_TASK_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace da {
+namespace executor {
+
+// A move-only `void()` callable. Callables of up to `kInlineSize` bytes are
+// stored inside the object itself and hence, creating, moving and running a
+// task does not touch the allocator. Larger callables fall back to the heap.
+class InlineTask {
+ public:
+  static const std::size_t kInlineSize = 64;
+
+  InlineTask() noexcept : ops_(nullptr) {}
+
+  InlineTask(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+  template <typename Function,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<Function>::type, InlineTask>::value>::type>
+  InlineTask(Function&& f) : ops_(nullptr) {
+    emplace(std::forward<Function>(f));
+  }
+
+  InlineTask(InlineTask&& task) noexcept : ops_(nullptr) {
+    moveFrom(task);
+  }
+
+  InlineTask& operator=(InlineTask&& task) noexcept {
+    if (this != &task) {
+      reset();
+      moveFrom(task);
+    }
+    return *this;
+  }
+
+  ~InlineTask() { reset(); }
+
+  // Delete the copy constructor.
+  InlineTask(const InlineTask&) = delete;
+  // Delete the copy assignment operator.
+  InlineTask& operator=(const InlineTask&) = delete;
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  void operator()() {
+    if (ops_ == nullptr) {
+      return;
+    }
+    ops_->invoke(&storage_);
+  }
+
+ private:
+  // Type erased operations of the stored callable.
+  struct Ops {
+    void (*invoke)(void* storage);
+    // Move constructs into `to` and destroys what was left in `from`.
+    void (*relocate)(void* to, void* from);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename Function>
+  struct InlineOps {
+    static void invoke(void* storage) {
+      (*static_cast<Function*>(storage))();
+    }
+    static void relocate(void* to, void* from) {
+      new (to) Function(std::move(*static_cast<Function*>(from)));
+      static_cast<Function*>(from)->~Function();
+    }
+    static void destroy(void* storage) {
+      static_cast<Function*>(storage)->~Function();
+    }
+    static const Ops ops;
+  };
+
+  template <typename Function>
+  struct HeapOps {
+    static void invoke(void* storage) {
+      (**static_cast<Function**>(storage))();
+    }
+    static void relocate(void* to, void* from) {
+      *static_cast<Function**>(to) = *static_cast<Function**>(from);
+    }
+    static void destroy(void* storage) {
+      delete *static_cast<Function**>(storage);
+    }
+    static const Ops ops;
+  };
+
+  template <typename Function>
+  using FitsInline = std::integral_constant<
+      bool, sizeof(Function) <= kInlineSize &&
+                alignof(std::max_align_t) % alignof(Function) == 0 &&
+                std::is_nothrow_move_constructible<Function>::value>;
+
+  template <typename Function>
+  void emplace(Function&& f) {
+    using Decayed = typename std::decay<Function>::type;
+    construct<Decayed>(std::forward<Function>(f), FitsInline<Decayed>());
+  }
+
+  template <typename Decayed, typename Function>
+  void construct(Function&& f, std::true_type) {
+    new (&storage_) Decayed(std::forward<Function>(f));
+    ops_ = &InlineOps<Decayed>::ops;
+  }
+
+  template <typename Decayed, typename Function>
+  void construct(Function&& f, std::false_type) {
+    *reinterpret_cast<Decayed**>(&storage_) =
+        new Decayed(std::forward<Function>(f));
+    ops_ = &HeapOps<Decayed>::ops;
+  }
+
+  void moveFrom(InlineTask& task) noexcept {
+    if (task.ops_ == nullptr) {
+      return;
+    }
+    task.ops_->relocate(&storage_, &task.storage_);
+    ops_ = task.ops_;
+    task.ops_ = nullptr;
+  }
+
+  void reset() noexcept {
+    if (ops_ == nullptr) {
+      return;
+    }
+    ops_->destroy(&storage_);
+    ops_ = nullptr;
+  }
+
+  typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type
+      storage_;
+  const Ops* ops_;
+};
+
+template <typename Function>
+const InlineTask::Ops InlineTask::InlineOps<Function>::ops = {
+    &InlineTask::InlineOps<Function>::invoke,
+    &InlineTask::InlineOps<Function>::relocate,
+    &InlineTask::InlineOps<Function>::destroy};
+
+template <typename Function>
+const InlineTask::Ops InlineTask::HeapOps<Function>::ops = {
+    &InlineTask::HeapOps<Function>::invoke,
+    &InlineTask::HeapOps<Function>::relocate,
+    &InlineTask::HeapOps<Function>::destroy};
+
+}  // namespace executor
+}  // namespace da
+
+#endif  // __INCLUDED_DA_EXECUTOR_INLINE_TASK_H_
@@ -0,0 +1,157 @@
+#ifndef __INCLUDED_DA_EXECUTOR_MPMC_RING_BUFFER_H_
+#define __INCLUDED_DA_EXECUTOR_MPMC_RING_BUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace da {
+namespace executor {
+
+// A lock-free bounded multi producer multi consumer queue based on Dmitry
+// Vyukov's design. Every slot carries a sequence number that tells producers
+// and consumers whose turn it is, so an operation is a single CAS on the
+// position followed by a store to the slot. All the slots are allocated
+// upfront and hence, there is no allocation per element.
+template <typename T>
+class MPMCRingBuffer {
+ public:
+  // The capacity is rounded up to the next power of two.
+  MPMCRingBuffer(std::size_t capacity);
+  ~MPMCRingBuffer() {}
+
+  // Delete the copy constructor.
+  MPMCRingBuffer(const MPMCRingBuffer&) = delete;
+  // Delete the copy assignment operator.
+  MPMCRingBuffer& operator=(const MPMCRingBuffer&) = delete;
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  // Is exact only when there are no concurrent operations.
+  std::size_t size() const;
+
+  bool empty() const { return size() == 0; }
+
+  // Returns false without moving from `t` if the buffer is full.
+  bool enqueue(T&& t);
+
+  bool enqueue(const T& t) {
+    T copy = t;
+    return enqueue(std::move(copy));
+  }
+
+  // Returns false if the buffer is empty.
+  bool dequeue(T& t);
+
+ private:
+  static const std::size_t kCacheLineSize = 64;
+
+  static std::size_t roundUpToPowerOfTwo(std::size_t x);
+
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    T data;
+  };
+
+  // The positions are kept on separate cache lines so that producers and
+  // consumers do not invalidate each other's lines.
+  char pad0_[kCacheLineSize];
+  const std::size_t mask_;
+  const std::unique_ptr<Slot[]> slots_;
+  char pad1_[kCacheLineSize];
+  std::atomic<std::size_t> enqueue_pos_;
+  char pad2_[kCacheLineSize - sizeof(std::atomic<std::size_t>)];
+  std::atomic<std::size_t> dequeue_pos_;
+  char pad3_[kCacheLineSize - sizeof(std::atomic<std::size_t>)];
+};
+
+template <typename T>
+std::size_t MPMCRingBuffer<T>::roundUpToPowerOfTwo(std::size_t x) {
+  std::size_t power = 1;
+  while (power < x) {
+    power <<= 1;
+  }
+  return power;
+}
+
+template <typename T>
+MPMCRingBuffer<T>::MPMCRingBuffer(std::size_t capacity)
+    : mask_(roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity) - 1),
+      slots_(new Slot[mask_ + 1]),
+      enqueue_pos_(0),
+      dequeue_pos_(0) {
+  for (std::size_t i = 0; i <= mask_; i++) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+std::size_t MPMCRingBuffer<T>::size() const {
+  const std::size_t tail = dequeue_pos_.load(std::memory_order_relaxed);
+  const std::size_t head = enqueue_pos_.load(std::memory_order_relaxed);
+  return head > tail ? head - tail : 0;
+}
+
+template <typename T>
+bool MPMCRingBuffer<T>::enqueue(T&& t) {
+  std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &slots_[pos & mask_];
+    const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<std::ptrdiff_t>(sequence) -
+                      static_cast<std::ptrdiff_t>(pos);
+    if (diff == 0) {
+      // The slot is free. Claim it by moving the position forward.
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds an element from the previous lap.
+      return false;
+    } else {
+      // Some other producer claimed the slot.
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->data = std::move(t);
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool MPMCRingBuffer<T>::dequeue(T& t) {
+  std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &slots_[pos & mask_];
+    const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<std::ptrdiff_t>(sequence) -
+                      static_cast<std::ptrdiff_t>(pos + 1);
+    if (diff == 0) {
+      // The slot is filled. Claim it by moving the position forward.
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot has not been filled yet.
+      return false;
+    } else {
+      // Some other consumer claimed the slot.
+      pos = dequeue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  t = std::move(slot->data);
+  // Release whatever the moved-from element still holds.
+  slot->data = T();
+  slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+  return true;
+}
+
+}  // namespace executor
+}  // namespace da
+
+#endif  // __INCLUDED_DA_EXECUTOR_MPMC_RING_BUFFER_H_
@@ -8,7 +8,17 @@ namespace executor {
 Scheduler::Scheduler() : Scheduler(std::thread::hardware_concurrency()) {}
 
 Scheduler::Scheduler(int no_of_threads)
-    : alive_(true), workers_(std::vector<std::thread>(no_of_threads)) {
+    : Scheduler(no_of_threads, std::chrono::microseconds::zero()) {}
+
+Scheduler::Scheduler(int no_of_threads, std::chrono::microseconds tick)
+    : alive_(true),
+      workers_(std::vector<std::thread>(no_of_threads)),
+      next_task_id_(1),
+      tick_(tick),
+      start_(std::chrono::high_resolution_clock::now()) {
+  if (tick_ > std::chrono::microseconds::zero()) {
+    wheel_ = std::make_unique<TimingWheel>();
+  }
   for (int id = 0; id < int(workers_.size()); id++) {
     workers_[id] = std::thread(Worker(id, this));
   }
@@ -20,9 +30,18 @@ Scheduler::~Scheduler() {
   }
 }
 
-void Scheduler::waitForCompletion() {
+void Scheduler::stop() {
   alive_ = false;
   queue_.stop();
+  std::unique_lock<std::mutex> lock(mutex_);
+  pending_tasks_.clear();
+  if (wheel_ != nullptr) {
+    wheel_->clear();
+  }
+}
+
+void Scheduler::waitForCompletion() {
+  stop();
   {
     std::unique_lock<std::mutex> lock(mutex_);
     cond_var_.notify_all();
@@ -34,10 +53,98 @@ void Scheduler::waitForCompletion() {
   }
 }
 
+TimerHandle Scheduler::submit(
+    InlineTask f,
+    std::chrono::time_point<std::chrono::high_resolution_clock> time) {
+  if (wheel_ == nullptr) {
+    uint64_t id;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      id = next_task_id_++;
+      pending_tasks_.insert(id);
+    }
+    queue_.enqueue(Task(std::move(f), time, id));
+    // Wake up a thread to execute the function (if it was waiting).
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.notify_one();
+    return TimerHandle(id);
+  }
+  const uint64_t expiry = toTick(time, true);
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!isAlive()) {
+    return TimerHandle();
+  }
+  // A worker only needs to be woken up if it is sleeping past this expiry.
+  const bool is_earliest = expiry < wheel_->nextExpiry();
+  const uint64_t id = wheel_->insert(expiry, std::move(f));
+  if (is_earliest) {
+    cond_var_.notify_one();
+  }
+  return TimerHandle(id);
+}
+
+bool Scheduler::cancel(TimerHandle handle) {
+  if (!handle.isValid()) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (wheel_ == nullptr) {
+    // The task stays in the heap and is dropped once it is due.
+    return pending_tasks_.erase(handle.id_) > 0;
+  }
+  return wheel_->cancel(handle.id_);
+}
+
+void Scheduler::runExpired() {
+  if (wheel_ == nullptr) {
+    return;
+  }
+  std::vector<InlineTask> expired;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wheel_->advance(toTick(std::chrono::high_resolution_clock::now(), false),
+                    expired);
+  }
+  for (auto& f : expired) {
+    if (!isAlive()) {
+      break;
+    }
+    f();
+  }
+}
+
+uint64_t Scheduler::toTick(
+    std::chrono::time_point<std::chrono::high_resolution_clock> time,
+    bool round_up) const {
+  if (time <= start_) {
+    return 0;
+  }
+  const auto elapsed =
+      std::chrono::duration_cast<std::chrono::microseconds>(time - start_);
+  uint64_t ticks = elapsed / tick_;
+  if (round_up && elapsed % tick_ != std::chrono::microseconds::zero()) {
+    ticks += 1;
+  }
+  return ticks;
+}
+
+std::chrono::time_point<std::chrono::high_resolution_clock> Scheduler::toTime(
+    uint64_t tick) const {
+  return start_ + std::chrono::microseconds(tick * tick_.count());
+}
+
 Scheduler::Worker::Worker(int id, Scheduler* scheduler)
     : id_(id), scheduler_(scheduler) {}
 
 void Scheduler::Worker::operator()() {
+  if (scheduler_->wheel_ != nullptr) {
+    runTimingWheel();
+  } else {
+    runMinHeap();
+  }
+}
+
+void Scheduler::Worker::runMinHeap() {
   while (scheduler_->isAlive()) {
     Task task;
     {
@@ -59,22 +166,63 @@ void Scheduler::Worker::operator()() {
     // There is no need to wake up another thread since, this thread will
     // execute the task in the next loop.
     if (task.getTime() > std::chrono::high_resolution_clock::now()) {
-      scheduler_->queue_.enqueue(task);
+      scheduler_->queue_.enqueue(std::move(task));
       util::nanosleep(10000);
       continue;
     }
+    {
+      // Skip the task if it was cancelled.
+      std::unique_lock<std::mutex> lock(scheduler_->mutex_);
+      if (scheduler_->pending_tasks_.erase(task.getId()) == 0) {
+        continue;
+      }
+    }
     task();
   }
 }
 
+void Scheduler::Worker::runTimingWheel() {
+  std::vector<InlineTask> expired;
+  while (scheduler_->isAlive()) {
+    {
+      std::unique_lock<std::mutex> lock(scheduler_->mutex_);
+      while (scheduler_->isAlive()) {
+        const uint64_t now =
+            scheduler_->toTick(std::chrono::high_resolution_clock::now(), false);
+        scheduler_->wheel_->advance(now, expired);
+        if (!expired.empty()) {
+          break;
+        }
+        // Sleep until the next tick that has something to execute or until
+        // an earlier function is added.
+        const uint64_t next = scheduler_->wheel_->nextExpiry();
+        if (next == TimingWheel::kNever) {
+          scheduler_->cond_var_.wait(lock);
+        } else {
+          scheduler_->cond_var_.wait_until(lock, scheduler_->toTime(next));
+        }
+      }
+    }
+    for (auto& f : expired) {
+      if (!scheduler_->isAlive()) {
+        break;
+      }
+      f();
+    }
+    expired.clear();
+  }
+}
+
 Scheduler::Task::Task()
     : f_(nullptr),
-      time_(std::chrono::time_point<std::chrono::high_resolution_clock>()) {}
+      time_(std::chrono::time_point<std::chrono::high_resolution_clock>()),
+      id_(0) {}
 
 Scheduler::Task::Task(
-    const std::function<void()>& f,
-    std::chrono::time_point<std::chrono::high_resolution_clock> time)
-    : f_(f), time_(time) {}
+    InlineTask f,
+    std::chrono::time_point<std::chrono::high_resolution_clock> time,
+    uint64_t id)
+    : f_(std::move(f)), time_(time), id_(id) {}
 
 bool Scheduler::Task::operator<(const Scheduler::Task& task) const {
   return this->time_ < task.getTime();
@@ -89,8 +237,10 @@ Scheduler::Task::getTime() const {
   return time_;
 }
 
+uint64_t Scheduler::Task::getId() const { return id_; }
+
 void Scheduler::Task::operator()() {
-  if (f_ == nullptr) {
+  if (!f_) {
     return;
   }
   f_();
@@ -3,24 +3,50 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <da/executor/inline_task.h>
 #include <da/executor/thread_safe_min_heap.h>
+#include <da/executor/timing_wheel.h>
 
 namespace da {
 namespace executor {
 
+// Identifies a function posted to the scheduler so that it can be cancelled
+// before it is executed. It is a plain integer and hence, cheap to copy.
+class TimerHandle {
+ public:
+  TimerHandle() : id_(0) {}
+
+  bool isValid() const { return id_ != 0; }
+
+ private:
+  friend class Scheduler;
+
+  explicit TimerHandle(uint64_t id) : id_(id) {}
+
+  uint64_t id_;
+};
+
 class Scheduler {
  public:
   Scheduler();
 
   Scheduler(int no_of_threads);
 
+  // Uses a hierarchical timing wheel with the given tick instead of a min heap.
+  // Functions are executed at the first tick at or after their time and the
+  // workers sleep until the next tick that has something to execute.
+  Scheduler(int no_of_threads, std::chrono::microseconds tick);
+
   ~Scheduler();
 
   // Delete the copy constructor.
@@ -34,10 +60,7 @@ class Scheduler {
 
   bool isAlive() const { return alive_; }
 
-  void stop() {
-    alive_ = false;
-    queue_.stop();
-  }
+  void stop();
 
   void waitForCompletion();
 
@@ -52,15 +75,59 @@ class Scheduler {
   auto schedule(std::chrono::microseconds interval, Function&& f,
                 Args&&... args) -> std::future<decltype(f(args...))>;
 
+  // Adds the function to be executed as soon as possible without a way to
+  // wait for its result. Does not allocate as long as the callable fits in an
+  // `InlineTask`.
+  template <typename Function>
+  TimerHandle post(Function&& f);
+
+  // Adds the function with a delay of interval microseconds in execution
+  // without a way to wait for its result.
+  template <typename Function>
+  TimerHandle post(std::chrono::microseconds interval, Function&& f);
+
+  // Removes the function so that it is never executed. With a timing wheel
+  // the function is removed from its slot right away. Returns false if the
+  // function has already been executed (or is being executed) or cancelled.
+  bool cancel(TimerHandle handle);
+
+  // Executes the functions of the timing wheel that have expired on the calling
+  // thread. Lets an event loop drive a scheduler that has been created without
+  // any threads of its own.
+  void runExpired();
+
  private:
   class Task;
   class Worker;
 
+  // Enqueues the function to be executed at the given time and wakes up a
+  // worker.
+  TimerHandle submit(
+      InlineTask f,
+      std::chrono::time_point<std::chrono::high_resolution_clock> time);
+
+  // Converts the time to the number of ticks elapsed since the start of the
+  // timing wheel, rounding towards the future if `round_up` is set.
+  uint64_t toTick(
+      std::chrono::time_point<std::chrono::high_resolution_clock> time,
+      bool round_up) const;
+
+  std::chrono::time_point<std::chrono::high_resolution_clock> toTime(
+      uint64_t tick) const;
+
   std::atomic<bool> alive_;
   std::vector<std::thread> workers_;
   ThreadSafeMinHeap<Task> queue_;
   std::mutex mutex_;
   std::condition_variable cond_var_;
+  // Used only with the min heap. Denotes the ids of the tasks that have been
+  // neither executed nor cancelled. Guarded by `mutex_`.
+  std::unordered_set<uint64_t> pending_tasks_;
+  uint64_t next_task_id_;
+  // Used only if the scheduler was created with a tick. Guarded by `mutex_`.
+  const std::chrono::microseconds tick_;
+  const std::chrono::time_point<std::chrono::high_resolution_clock> start_;
+  std::unique_ptr<TimingWheel> wheel_;
 };
 
 class Scheduler::Worker {
@@ -70,6 +137,12 @@ class Scheduler::Worker {
   void operator()();
 
  private:
+  // Executes the functions from the min heap.
+  void runMinHeap();
+
+  // Executes the functions expiring in the timing wheel.
+  void runTimingWheel();
+
   const int id_;
   Scheduler* scheduler_;
 };
@@ -78,8 +151,12 @@ class Scheduler::Task {
  public:
   Task();
 
-  Task(const std::function<void()>& f,
-       std::chrono::time_point<std::chrono::high_resolution_clock> time);
+  Task(InlineTask f,
+       std::chrono::time_point<std::chrono::high_resolution_clock> time,
+       uint64_t id);
+
+  Task(Task&&) = default;
+  Task& operator=(Task&&) = default;
 
   bool operator<(const Task& task) const;
 
@@ -89,9 +166,12 @@ class Scheduler::Task {
 
   std::chrono::time_point<std::chrono::high_resolution_clock> getTime() const;
 
+  uint64_t getId() const;
+
  private:
-  std::function<void()> f_;
+  InlineTask f_;
   std::chrono::time_point<std::chrono::high_resolution_clock> time_;
+  uint64_t id_;
 };
 
 template <typename Function, typename... Args>
@@ -111,17 +191,22 @@ auto Scheduler::schedule(std::chrono::microseconds interval, Function&& f,
   auto task =
       std::make_shared<std::packaged_task<decltype(f(args...))()>>(func);
   // Correct the type and enqueue it to be executed.
-  std::function<void()> ret_void_func = [task]() { (*task)(); };
-  queue_.enqueue(Task(ret_void_func, time));
-  // Wake up a thread to execute the function (if it was waiting).
-  {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cond_var_.notify_one();
-  }
+  submit([task]() { (*task)(); }, time);
   // Return a future if there was a return type expected.
   return task->get_future();
 }
 
+template <typename Function>
+TimerHandle Scheduler::post(Function&& f) {
+  return post(std::chrono::microseconds::zero(), std::forward<Function>(f));
+}
+
+template <typename Function>
+TimerHandle Scheduler::post(std::chrono::microseconds interval, Function&& f) {
+  return submit(InlineTask(std::forward<Function>(f)),
+                std::chrono::high_resolution_clock::now() + interval);
+}
+
 }  // namespace executor
 }  // namespace da
 
@@ -1,14 +1,18 @@
 #ifndef __INCLUDED_DA_EXECUTOR_THREAD_SAFE_MIN_HEAP_H_
 #define __INCLUDED_DA_EXECUTOR_THREAD_SAFE_MIN_HEAP_H_
 
+#include <algorithm>
 #include <atomic>
+#include <functional>
 #include <mutex>
-#include <queue>
+#include <utility>
 #include <vector>
 
 namespace da {
 namespace executor {
 
+// The heap is kept in a vector rather than a `std::priority_queue` so that the
+// top element can be moved out. This allows `T` to be move-only.
 template <typename T>
 class ThreadSafeMinHeap {
  public:
@@ -26,7 +30,7 @@ class ThreadSafeMinHeap {
   void stop() {
     alive_ = false;
     std::unique_lock<std::mutex> lock(mutex_);
-    queue_ = std::priority_queue<T, std::vector<T>, std::greater<T>>();
+    queue_.clear();
   }
 
   int size() {
@@ -34,12 +38,13 @@ class ThreadSafeMinHeap {
     return queue_.size();
   }
 
-  void enqueue(const T& t) {
+  void enqueue(T t) {
     if (!alive_) {
       return;
     }
     std::unique_lock<std::mutex> lock(mutex_);
-    queue_.push(t);
+    queue_.push_back(std::move(t));
+    std::push_heap(queue_.begin(), queue_.end(), std::greater<T>());
   }
 
   bool dequeue(T& t) {
@@ -50,15 +55,16 @@ class ThreadSafeMinHeap {
     if (queue_.empty()) {
       return false;
     }
-    t = std::move(queue_.top());
-    queue_.pop();
+    std::pop_heap(queue_.begin(), queue_.end(), std::greater<T>());
+    t = std::move(queue_.back());
+    queue_.pop_back();
     return true;
   }
 
  private:
   std::mutex mutex_;
   std::atomic<bool> alive_;
-  std::priority_queue<T, std::vector<T>, std::greater<T>> queue_;
+  std::vector<T> queue_;
 };
 
 }  // namespace executor
@@ -2,50 +2,98 @@
 #define __INCLUDED_DA_EXECUTOR_THREAD_SAFE_QUEUE_H_
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <utility>
 #include <vector>
 
+#include <da/executor/mpmc_ring_buffer.h>
+
 namespace da {
 namespace executor {
 
+// By default the queue is unbounded and guarded by a mutex. If a capacity is
+// provided then the queue is instead backed by a lock-free bounded ring buffer
+// and enqueue fails when the ring is full.
 template <typename T>
 class ThreadSafeQueue {
  public:
   ThreadSafeQueue() : alive_(true) {}
+  ThreadSafeQueue(int capacity)
+      : alive_(true),
+        ring_(capacity > 0 ? std::make_unique<MPMCRingBuffer<T>>(capacity)
+                           : nullptr) {}
   ~ThreadSafeQueue() {}
 
+  bool isBounded() const { return ring_ != nullptr; }
+
+  bool isStopped() const { return !alive_; }
+
   bool empty() {
     if (!alive_) {
       return true;
     }
+    if (ring_ != nullptr) {
+      return ring_->empty();
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     return queue_.empty();
   }
 
   void stop() {
     alive_ = false;
+    if (ring_ != nullptr) {
+      T t;
+      while (ring_->dequeue(t)) {
+      }
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     queue_ = std::queue<T>();
   }
 
   int size() {
+    if (ring_ != nullptr) {
+      return ring_->size();
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     return queue_.size();
   }
 
-  void enqueue(const T& t) {
+  // Returns false if the queue has been stopped or the ring is full.
+  bool enqueue(const T& t) {
     if (!alive_) {
-      return;
+      return false;
+    }
+    if (ring_ != nullptr) {
+      return ring_->enqueue(t);
     }
     std::unique_lock<std::mutex> lock(mutex_);
     queue_.push(t);
+    return true;
+  }
+
+  // Does not move from `t` if false is returned.
+  bool enqueue(T&& t) {
+    if (!alive_) {
+      return false;
+    }
+    if (ring_ != nullptr) {
+      return ring_->enqueue(std::move(t));
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push(std::move(t));
+    return true;
   }
 
   bool dequeue(T& t) {
     if (!alive_) {
       return false;
     }
+    if (ring_ != nullptr) {
+      return ring_->dequeue(t);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     if (queue_.empty()) {
       return false;
@@ -59,6 +107,7 @@ class ThreadSafeQueue {
   std::mutex mutex_;
   std::atomic<bool> alive_;
   std::queue<T> queue_;
+  const std::unique_ptr<MPMCRingBuffer<T>> ring_;
 };
 
 }  // namespace executor
@@ -0,0 +1,252 @@
+#include <da/executor/timing_wheel.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace da {
+namespace executor {
+namespace {
+
+inline uint64_t toTimerId(uint32_t generation, uint32_t timer) {
+  return (uint64_t(generation) << 32) | timer;
+}
+
+}  // namespace
+
+const int TimingWheel::kBits;
+const int TimingWheel::kSlots;
+const int TimingWheel::kLevels;
+const uint64_t TimingWheel::kNever;
+const uint64_t TimingWheel::kInvalidTimer;
+const int TimingWheel::kWords;
+const int TimingWheel::kReady;
+
+TimingWheel::TimingWheel() : current_tick_(0), size_(0) {
+  for (auto& level : levels_) {
+    level.occupied.fill(0);
+  }
+}
+
+uint64_t TimingWheel::insert(uint64_t expiry, InlineTask f) {
+  const uint32_t timer = acquireTimer();
+  insert(Entry{expiry, timer, std::move(f)});
+  size_ += 1;
+  return toTimerId(timers_[timer].generation, timer);
+}
+
+bool TimingWheel::cancel(uint64_t timer_id) {
+  const uint32_t timer = timer_id & UINT32_MAX;
+  if (timer >= timers_.size() ||
+      timers_[timer].generation != uint32_t(timer_id >> 32) ||
+      timers_[timer].level == -1) {
+    return false;
+  }
+  const Timer location = timers_[timer];
+  Slot& slot = getSlot(location.level, location.slot);
+  // Fill the hole with the last entry of the slot.
+  if (location.index != int(slot.size()) - 1) {
+    slot[location.index] = std::move(slot.back());
+    timers_[slot[location.index].timer].index = location.index;
+  }
+  slot.pop_back();
+  if (slot.empty() && location.level != kReady) {
+    clearOccupied(location.level, location.slot);
+  }
+  releaseTimer(timer);
+  size_ -= 1;
+  return true;
+}
+
+void TimingWheel::insert(Entry entry) {
+  Timer& timer = timers_[entry.timer];
+  if (entry.expiry <= current_tick_) {
+    timer.level = kReady;
+    timer.slot = 0;
+    timer.index = ready_.size();
+    ready_.push_back(std::move(entry));
+    return;
+  }
+  uint64_t delta = entry.expiry - current_tick_;
+  // Tasks beyond the range of the highest level wait in its farthest slot and
+  // are placed again when that slot is cascaded.
+  const uint64_t max_delta = (uint64_t(1) << (kBits * kLevels)) - 1;
+  if (delta > max_delta) {
+    delta = max_delta;
+  }
+  int level = 0;
+  while (level < kLevels - 1 &&
+         delta >= (uint64_t(1) << (kBits * (level + 1)))) {
+    level += 1;
+  }
+  const int slot = ((current_tick_ + delta) >> (kBits * level)) & (kSlots - 1);
+  timer.level = level;
+  timer.slot = slot;
+  timer.index = levels_[level].slots[slot].size();
+  levels_[level].slots[slot].push_back(std::move(entry));
+  setOccupied(level, slot);
+}
+
+TimingWheel::Slot& TimingWheel::getSlot(int level, int slot) {
+  if (level == kReady) {
+    return ready_;
+  }
+  return levels_[level].slots[slot];
+}
+
+uint32_t TimingWheel::acquireTimer() {
+  if (free_timers_.empty()) {
+    timers_.push_back(Timer{1, -1, -1, -1});
+    return timers_.size() - 1;
+  }
+  const uint32_t timer = free_timers_.back();
+  free_timers_.pop_back();
+  return timer;
+}
+
+void TimingWheel::releaseTimer(uint32_t timer) {
+  timers_[timer].generation += 1;
+  // Generation zero would make the id of the first timer invalid.
+  if (timers_[timer].generation == 0) {
+    timers_[timer].generation = 1;
+  }
+  timers_[timer].level = -1;
+  free_timers_.push_back(timer);
+}
+
+void TimingWheel::advance(uint64_t tick, std::vector<InlineTask>& expired) {
+  if (!ready_.empty()) {
+    collect(-1, expired);
+  }
+  while (current_tick_ < tick) {
+    const uint64_t boundary = (current_tick_ | (kSlots - 1)) + 1;
+    if (current_tick_ + 1 < boundary) {
+      // Jump to the next occupied slot of the lowest level within the current
+      // revolution.
+      const uint64_t last = std::min(tick, boundary - 1);
+      const int slot = findOccupied(0, (current_tick_ + 1) & (kSlots - 1),
+                                    last & (kSlots - 1));
+      if (slot == -1) {
+        current_tick_ = last;
+        continue;
+      }
+      current_tick_ = (current_tick_ & ~uint64_t(kSlots - 1)) + slot;
+      collect(slot, expired);
+      continue;
+    }
+    // The lowest level completes a revolution. Cascade the slots of the higher
+    // levels that are now due, starting from the highest one.
+    current_tick_ = boundary;
+    int level = 1;
+    while (level < kLevels - 1 &&
+           ((current_tick_ >> (kBits * level)) & (kSlots - 1)) == 0) {
+      level += 1;
+    }
+    for (; level >= 1; level--) {
+      cascade(level, (current_tick_ >> (kBits * level)) & (kSlots - 1));
+    }
+    collect(0, expired);
+  }
+}
+
+uint64_t TimingWheel::nextExpiry() const {
+  if (!ready_.empty()) {
+    return current_tick_;
+  }
+  if (size_ == 0) {
+    return kNever;
+  }
+  const uint64_t boundary = (current_tick_ | (kSlots - 1)) + 1;
+  if (current_tick_ + 1 < boundary) {
+    const int slot =
+        findOccupied(0, (current_tick_ + 1) & (kSlots - 1), kSlots - 1);
+    if (slot != -1) {
+      return (current_tick_ & ~uint64_t(kSlots - 1)) + slot;
+    }
+  }
+  // Everything else is either in the next revolution of the lowest level or in
+  // a higher level. Nothing can expire before the next cascade.
+  return boundary;
+}
+
+void TimingWheel::clear() {
+  for (auto& level : levels_) {
+    for (auto& slot : level.slots) {
+      for (const auto& entry : slot) {
+        releaseTimer(entry.timer);
+      }
+      slot.clear();
+    }
+    level.occupied.fill(0);
+  }
+  for (const auto& entry : ready_) {
+    releaseTimer(entry.timer);
+  }
+  ready_.clear();
+  size_ = 0;
+}
+
+void TimingWheel::cascade(int level, int slot) {
+  if (levels_[level].slots[slot].empty()) {
+    return;
+  }
+  // Swap the slot out since an entry beyond the range of the highest level may
+  // be re-inserted into the very same slot.
+  Slot entries;
+  entries.swap(levels_[level].slots[slot]);
+  clearOccupied(level, slot);
+  for (auto& entry : entries) {
+    insert(std::move(entry));
+  }
+  // Hand the capacity back to the slot unless it was refilled.
+  entries.clear();
+  if (levels_[level].slots[slot].empty()) {
+    levels_[level].slots[slot].swap(entries);
+  }
+}
+
+void TimingWheel::collect(int slot, std::vector<InlineTask>& expired) {
+  for (auto& entry : ready_) {
+    releaseTimer(entry.timer);
+    expired.push_back(std::move(entry.f));
+  }
+  size_ -= ready_.size();
+  ready_.clear();
+  if (slot == -1) {
+    return;
+  }
+  auto& entries = levels_[0].slots[slot];
+  for (auto& entry : entries) {
+    releaseTimer(entry.timer);
+    expired.push_back(std::move(entry.f));
+  }
+  size_ -= entries.size();
+  entries.clear();
+  clearOccupied(0, slot);
+}
+
+int TimingWheel::findOccupied(int level, int from, int to) const {
+  for (int word = from / 64; word <= to / 64; word++) {
+    uint64_t bits = levels_[level].occupied[word];
+    if (word == from / 64) {
+      bits &= ~uint64_t(0) << (from % 64);
+    }
+    if (word == to / 64 && to % 64 != 63) {
+      bits &= (uint64_t(1) << (to % 64 + 1)) - 1;
+    }
+    if (bits != 0) {
+      return word * 64 + __builtin_ctzll(bits);
+    }
+  }
+  return -1;
+}
+
+void TimingWheel::setOccupied(int level, int slot) {
+  levels_[level].occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+}
+
+void TimingWheel::clearOccupied(int level, int slot) {
+  levels_[level].occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+}
+
+}  // namespace executor
+}  // namespace da
@@ -0,0 +1,127 @@
+#ifndef __INCLUDED_DA_EXECUTOR_TIMING_WHEEL_H_
+#define __INCLUDED_DA_EXECUTOR_TIMING_WHEEL_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <da/executor/inline_task.h>
+
+namespace da {
+namespace executor {
+
+// A hierarchical timing wheel. Time is measured in ticks and every level has
+// `kSlots` slots, each slot spanning `kSlots` times more ticks than a slot of
+// the level below. A task is placed in the lowest level that can hold its
+// expiry and moves one level down every time the wheel below completes a
+// revolution. Insertion and expiry are O(1) and advancing over empty slots is
+// done a word of the occupancy bitmap at a time.
+//
+// Every task is identified by a timer id that can be used to cancel it. A
+// cancelled task is removed from its slot right away in O(1).
+//
+// The wheel is not thread-safe.
+class TimingWheel {
+ public:
+  static const int kBits = 8;
+  static const int kSlots = 1 << kBits;
+  static const int kLevels = 4;
+  // Denotes that there is no task in the wheel.
+  static const uint64_t kNever = UINT64_MAX;
+  // Denotes a timer id that never refers to a task.
+  static const uint64_t kInvalidTimer = 0;
+
+  TimingWheel();
+
+  // Denotes the tick up to which all the expired tasks have been collected.
+  uint64_t getCurrentTick() const { return current_tick_; }
+
+  bool empty() const { return size_ == 0; }
+
+  int size() const { return size_; }
+
+  // Adds a task that expires at the given tick and returns its timer id. Tasks
+  // that have already expired are returned by the next call to `advance`.
+  uint64_t insert(uint64_t expiry, InlineTask f);
+
+  // Removes the task with the given timer id. Returns false if the task has
+  // already expired or been cancelled.
+  bool cancel(uint64_t timer);
+
+  // Moves the wheel forward to `tick` and appends the tasks that expired on the
+  // way to `expired` in the order of their expiry.
+  void advance(uint64_t tick, std::vector<InlineTask>& expired);
+
+  // Returns the earliest tick at which `advance` might find an expired task.
+  // This is exact for the tasks of the lowest level and a lower bound for the
+  // rest.
+  uint64_t nextExpiry() const;
+
+  // Removes all the tasks.
+  void clear();
+
+ private:
+  static const int kWords = kSlots / 64;
+
+  // Denotes the level of the tasks that were inserted after their expiry.
+  static const int kReady = kLevels;
+
+  struct Entry {
+    uint64_t expiry;
+    // Index into `timers_`.
+    uint32_t timer;
+    InlineTask f;
+  };
+
+  using Slot = std::vector<Entry>;
+
+  // Locates the entry of a task. The generation is bumped every time the timer
+  // is released so that stale timer ids can be told apart.
+  struct Timer {
+    uint32_t generation;
+    int level;
+    int slot;
+    int index;
+  };
+
+  struct Level {
+    std::array<Slot, kSlots> slots;
+    // Denotes the slots that are non-empty.
+    std::array<uint64_t, kWords> occupied;
+  };
+
+  void insert(Entry entry);
+
+  Slot& getSlot(int level, int slot);
+
+  // Allocates a timer for a new entry.
+  uint32_t acquireTimer();
+
+  // Releases the timer of an entry that left the wheel.
+  void releaseTimer(uint32_t timer);
+
+  // Re-inserts the tasks of the given slot relative to the current tick.
+  void cascade(int level, int slot);
+
+  // Appends the tasks of the given lowest level slot to `expired`.
+  void collect(int slot, std::vector<InlineTask>& expired);
+
+  // Returns the first occupied slot of the level in [from, to] or -1.
+  int findOccupied(int level, int from, int to) const;
+
+  void setOccupied(int level, int slot);
+  void clearOccupied(int level, int slot);
+
+  uint64_t current_tick_;
+  int size_;
+  std::array<Level, kLevels> levels_;
+  // Holds tasks that were inserted after their expiry.
+  Slot ready_;
+  std::vector<Timer> timers_;
+  std::vector<uint32_t> free_timers_;
+};
+
+}  // namespace executor
+}  // namespace da
+
+#endif  // __INCLUDED_DA_EXECUTOR_TIMING_WHEEL_H_
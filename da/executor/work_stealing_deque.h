@@ -0,0 +1,101 @@
+#ifndef __INCLUDED_DA_EXECUTOR_WORK_STEALING_DEQUE_H_
+#define __INCLUDED_DA_EXECUTOR_WORK_STEALING_DEQUE_H_
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace da {
+namespace executor {
+
+// A deque owned by a single worker. Tasks are pushed at the back and the owner
+// pops them from the front in FIFO order, while other workers steal the newest
+// ones from the back. Each deque has its own lock so that workers only contend
+// when one of them is stealing.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque() : alive_(true), size_(0) {}
+  ~WorkStealingDeque() {}
+
+  // Does not take the lock and hence, is only a hint.
+  bool empty() const { return !alive_ || size_ == 0; }
+
+  int size() const { return size_; }
+
+  void stop() {
+    alive_ = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    deque_.clear();
+    size_ = 0;
+  }
+
+  void enqueue(T t) {
+    if (!alive_) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    deque_.push_back(std::move(t));
+    size_ += 1;
+  }
+
+  // Enqueues all the elements of `ts` in order.
+  void enqueueAll(std::vector<T>& ts) {
+    if (!alive_ || ts.empty()) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto& t : ts) {
+      deque_.push_back(std::move(t));
+    }
+    size_ += ts.size();
+  }
+
+  bool dequeue(T& t) {
+    if (empty()) {
+      return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (deque_.empty()) {
+      return false;
+    }
+    t = std::move(deque_.front());
+    deque_.pop_front();
+    size_ -= 1;
+    return true;
+  }
+
+  // Moves the newer half (rounded up) of the elements into `stolen`, oldest
+  // first. Returns false if there was nothing to steal.
+  bool stealHalf(std::vector<T>& stolen) {
+    if (empty()) {
+      return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    const int count = (deque_.size() + 1) / 2;
+    if (count == 0) {
+      return false;
+    }
+    stolen.reserve(stolen.size() + count);
+    const auto begin = deque_.end() - count;
+    for (auto it = begin; it != deque_.end(); it++) {
+      stolen.push_back(std::move(*it));
+    }
+    deque_.erase(begin, deque_.end());
+    size_ -= count;
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::atomic<bool> alive_;
+  std::atomic<int> size_;
+  std::deque<T> deque_;
+};
+
+}  // namespace executor
+}  // namespace da
+
+#endif  // __INCLUDED_DA_EXECUTOR_WORK_STEALING_DEQUE_H_
@@ -10,6 +10,7 @@
 #include <unistd.h>
 
 #include <da/process/process.h>
+#include <da/socket/socket.h>
 #include <da/util/statusor.h>
 
 namespace da {
@@ -63,8 +64,16 @@ parseMembershipFile(const char* file, int current_process_id, int messages) {
           util::StatusCode::kOutOfRange,
           "Process id: " + std::to_string(process_id) + " is out of bounds.");
     }
+    // Resolve the address once for all the messages sent to this process.
+    sockaddr_in addr;
+    const auto status = socket::fillAddr(ip_addr, port, addr);
+    if (!status.ok()) {
+      membership.close();
+      return status;
+    }
     processes[process_id] = std::make_unique<process::Process>(
-        process_id, ip_addr, port, messages, current_process_id == process_id);
+        process_id, ip_addr, port, addr, messages,
+        current_process_id == process_id);
   }
 
   // Read localized dependencies.
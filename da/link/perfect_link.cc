@@ -1,16 +1,21 @@
 #include <da/link/perfect_link.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <functional>
+#include <map>
 #include <mutex>
+#include <random>
 #include <shared_mutex>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <da/executor/scheduler.h>
 #include <da/process/process.h>
-#include <da/socket/udp_socket.h>
+#include <da/transmitter/transmitter.h>
 #include <da/util/logging.h>
 #include <da/util/status.h>
 #include <da/util/statusor.h>
@@ -20,125 +25,347 @@ namespace da {
 namespace link {
 namespace {
 
-// Assumes that message has a valid minimum length.
-bool isAckMessage(const std::string& msg) {
-  return util::stringToBool(msg.data() + sizeof(uint16_t));
-}
-
-// Assumes that message has a valid minimum length.
-std::string constructInverseMessage(std::string msg, int process_id, bool ack) {
-  std::string process_id_str = util::integerToString<uint16_t>(process_id);
-  for (int i = 0; i < int(sizeof(uint16_t)); i++) {
-    msg[i] = process_id_str[i];
-  }
-  msg[sizeof(uint16_t)] = util::boolToString(ack)[0];
-  return msg;
-}
+const std::chrono::microseconds default_initial_rto(10000);
+const std::chrono::microseconds default_min_rto(1000);
+const std::chrono::microseconds default_max_rto(1000000);
+// The timeout stops doubling after this many retransmissions.
+const int max_backoff_shift = 16;
+// Denotes how long an acknowledgement is held back so that it covers more
+// messages. Set to one tick of the timing wheel da_proc schedules on, as a
+// shorter delay would be rounded up to the tick anyway.
+const std::chrono::microseconds ack_delay(1000);
+// Denotes the number of received messages after which they are acknowledged
+// right away.
+const int ack_threshold = 32;
+// Denotes the number of messages after the first missing one whose receipt an
+// acknowledgement reports.
+const int sack_bits = 64;
 
 }  // namespace
 
 const int max_length = 64 * sizeof(int);
-const int min_length = sizeof(uint16_t) + sizeof(bool);
+
+bool isAckMessage(util::BytesView msg) {
+  return msg.size() >= ack_length && LinkHeader::IsAck::load(msg.data()) != 0;
+}
 
 PerfectLink::PerfectLink(executor::Scheduler* scheduler,
-                         socket::UDPSocket* sock,
+                         transmitter::Transmitter* transmitter,
                          const process::Process* local_process,
                          const process::Process* foreign_process)
-    : PerfectLink(scheduler, sock, local_process, foreign_process,
-                  std::chrono::microseconds(10000)) {}
+    : PerfectLink(scheduler, transmitter, local_process, foreign_process,
+                  default_initial_rto) {}
 
 PerfectLink::PerfectLink(executor::Scheduler* scheduler,
-                         socket::UDPSocket* sock,
+                         transmitter::Transmitter* transmitter,
                          const process::Process* local_process,
                          const process::Process* foreign_process,
                          std::chrono::microseconds interval)
+    : PerfectLink(scheduler, transmitter, local_process, foreign_process,
+                  interval, std::min(interval, default_min_rto),
+                  std::max(interval, default_max_rto)) {}
+
+PerfectLink::PerfectLink(executor::Scheduler* scheduler,
+                         transmitter::Transmitter* transmitter,
+                         const process::Process* local_process,
+                         const process::Process* foreign_process,
+                         std::chrono::microseconds initial_rto,
+                         std::chrono::microseconds min_rto,
+                         std::chrono::microseconds max_rto)
     : scheduler_(scheduler),
-      sock_(sock),
+      transmitter_(transmitter),
       local_process_(local_process),
       foreign_process_(foreign_process),
-      interval_(interval) {}
+      min_rto_(min_rto),
+      max_rto_(max_rto),
+      rto_(std::min(std::max(initial_rto, min_rto), max_rto)),
+      srtt_(0),
+      rttvar_(0),
+      has_rtt_sample_(false),
+      random_engine_(local_process->getId() * 65599 + foreign_process->getId()),
+      next_seq_(0),
+      sweep_token_(0),
+      unacked_count_(0),
+      ack_token_(0) {}
 
 PerfectLink::~PerfectLink() {
   std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+  scheduler_->cancel(sweep_timer_);
+  scheduler_->cancel(ack_timer_);
   undelivered_messages_.clear();
-}
-
-int PerfectLink::constructIdentity(const std::string* msg) {
-  using namespace std::string_literals;
-  std::string link_msg = ""s;
-  link_msg += util::integerToString<uint16_t>(local_process_->getId());
-  link_msg += util::boolToString(false);
-  link_msg += *msg;
-  return identity_manager_.assignId(link_msg);
+  deadlines_.clear();
 }
 
 void PerfectLink::sendMessage(const std::string* msg) {
-  int id = constructIdentity(msg);
+  std::string link_msg;
+  std::string ack_msg;
   {
     std::unique_lock<std::shared_timed_mutex> lock(mutex_);
-    undelivered_messages_.insert(id);
+    link_msg = trackMessage(msg, next_seq_++);
+    // The pending acknowledgement rides along in the same datagram.
+    ack_msg = takeAck();
+  }
+  transmit(link_msg);
+  if (!ack_msg.empty()) {
+    transmit(ack_msg);
   }
-  sendMessageCallback(id);
 }
 
-void PerfectLink::sendMessageCallback(int id) {
-  {
-    std::shared_lock<std::shared_timed_mutex> lock(mutex_);
-    if (undelivered_messages_.find(id) == undelivered_messages_.end()) {
-      return;
-    }
-  }
-  const std::string* msg = identity_manager_.getValue(id);
+std::string PerfectLink::stageMessage(const std::string* msg, uint32_t seq) {
+  std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+  return trackMessage(msg, seq);
+}
+
+const std::string& PerfectLink::trackMessage(const std::string* msg,
+                                             uint32_t seq) {
+  const auto now = std::chrono::high_resolution_clock::now();
+  const auto deadline = now + getTimeout(1);
+  Unacked& unacked = undelivered_messages_[seq];
+  unacked.msg.resize(min_length + msg->size());
+  char* header = &unacked.msg[0];
+  LinkHeader::SenderId::store(header, local_process_->getId());
+  LinkHeader::IsAck::store(header, 0);
+  LinkHeader::Seq::store(header, seq);
+  memcpy(header + min_length, msg->data(), msg->size());
+  unacked.sent = now;
+  unacked.deadline = deadline;
+  unacked.transmissions = 1;
+  deadlines_.insert({deadline, seq});
+  armSweepTimer(now);
+  return unacked.msg;
+}
+
+void PerfectLink::transmit(const std::string& msg) {
   // The message is non-ascii and hence, cannot be printed.
-  LOG("Sending message '", util::stringToBinary(msg), "' to ",
+  LOG("Sending message '", util::stringToBinary(&msg), "' to ",
       *foreign_process_);
-  const auto status =
-      sock_->sendTo(msg->data(), msg->size(), foreign_process_->getIPAddr(),
-                    foreign_process_->getPort());
+  const auto status = transmitter_->sendTo(msg.data(), msg.size(),
+                                           foreign_process_->getAddr());
   if (!status.ok()) {
-    LOG("Sending of message '", util::stringToBinary(msg), "' to ",
+    LOG("Sending of message '", util::stringToBinary(&msg), "' to ",
         *foreign_process_, " failed. Status: ", status);
   }
-  scheduler_->schedule(interval_,
-                       std::bind(&PerfectLink::sendMessageCallback, this, id));
 }
 
-void PerfectLink::ackMessage(const std::string& msg) {
-  const std::string ack_msg =
-      constructInverseMessage(msg, local_process_->getId(), true);
-  const auto status =
-      sock_->sendTo(ack_msg.data(), ack_msg.size(),
-                    foreign_process_->getIPAddr(), foreign_process_->getPort());
-  if (!status.ok()) {
-    LOG("Sending of message '", util::stringToBinary(&ack_msg), "' to ",
-        *foreign_process_, " failed. Status: ", status);
+void PerfectLink::sweep(uint64_t token) {
+  std::vector<std::string> expired;
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    if (token != sweep_token_) {
+      // A newer sweep timer has been armed in the meantime.
+      return;
+    }
+    sweep_timer_ = executor::TimerHandle();
+    const auto now = std::chrono::high_resolution_clock::now();
+    // Messages are moved to the back of the order since their deadline is
+    // pushed into the future.
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+      const uint32_t seq = deadlines_.begin()->second;
+      deadlines_.erase(deadlines_.begin());
+      auto& unacked = undelivered_messages_[seq];
+      unacked.transmissions += 1;
+      unacked.sent = now;
+      unacked.deadline = now + getTimeout(unacked.transmissions);
+      deadlines_.insert({unacked.deadline, seq});
+      expired.push_back(unacked.msg);
+    }
+    armSweepTimer(now);
+    // The pending acknowledgement rides along with the retransmissions.
+    if (!expired.empty()) {
+      std::string ack_msg = takeAck();
+      if (!ack_msg.empty()) {
+        expired.push_back(std::move(ack_msg));
+      }
+    }
+  }
+  // Retransmit all the expired messages back to back.
+  for (const auto& msg : expired) {
+    transmit(msg);
   }
 }
 
-bool PerfectLink::recvMessage(const std::string& msg) {
-  if (isAckMessage(msg)) {
-    // The inverse message must already be there in the identity manager.
-    int id = identity_manager_.getId(
-        constructInverseMessage(msg, local_process_->getId(), false));
-    if (id == -1) {
-      return false;
+void PerfectLink::armSweepTimer(TimePoint now) {
+  if (deadlines_.empty()) {
+    return;
+  }
+  const auto deadline = deadlines_.begin()->first;
+  if (sweep_timer_.isValid() && sweep_time_ <= deadline) {
+    return;
+  }
+  scheduler_->cancel(sweep_timer_);
+  // Round up so that the sweep does not wake up before the deadline.
+  auto delay = std::chrono::duration_cast<std::chrono::microseconds>(
+      deadline - now + std::chrono::microseconds(1));
+  if (delay < std::chrono::microseconds::zero()) {
+    delay = std::chrono::microseconds::zero();
+  }
+  const uint64_t token = ++sweep_token_;
+  sweep_time_ = deadline;
+  sweep_timer_ =
+      scheduler_->post(delay, [this, token]() { sweep(token); });
+}
+
+std::chrono::microseconds PerfectLink::getTimeout(int transmissions) {
+  const int shift = std::min(transmissions - 1, max_backoff_shift);
+  auto timeout = std::min(rto_ * (int64_t(1) << shift), max_rto_);
+  if (transmissions > 1) {
+    // Spread the retransmissions over [timeout / 2, timeout].
+    std::uniform_int_distribution<int64_t> jitter(0, timeout.count() / 2);
+    timeout -= std::chrono::microseconds(jitter(random_engine_));
+  }
+  return std::max(timeout, min_rto_);
+}
+
+void PerfectLink::sampleRoundTripTime(std::chrono::microseconds rtt) {
+  if (!has_rtt_sample_) {
+    srtt_ = rtt;
+    rttvar_ = rtt / 2;
+    has_rtt_sample_ = true;
+  } else {
+    const auto delta = srtt_ > rtt ? srtt_ - rtt : rtt - srtt_;
+    rttvar_ = (3 * rttvar_ + delta) / 4;
+    srtt_ = (7 * srtt_ + rtt) / 8;
+  }
+  rto_ = std::min(std::max(srtt_ + 4 * rttvar_, min_rto_), max_rto_);
+}
+
+std::string PerfectLink::takeAck() {
+  if (unacked_count_ == 0) {
+    return std::string();
+  }
+  unacked_count_ = 0;
+  if (ack_timer_.isValid()) {
+    scheduler_->cancel(ack_timer_);
+    ack_timer_ = executor::TimerHandle();
+  }
+  std::string ack_msg(ack_length, '\0');
+  char* header = &ack_msg[0];
+  LinkHeader::SenderId::store(header, local_process_->getId());
+  LinkHeader::IsAck::store(header, 1);
+  LinkAck::RecvNext::store(header, received_.getLowWatermark());
+  LinkAck::Bitmap::store(header, received_.getBitmapAfterLowWatermark());
+  return ack_msg;
+}
+
+void PerfectLink::armAckTimer() {
+  if (ack_timer_.isValid()) {
+    return;
+  }
+  const uint64_t token = ++ack_token_;
+  ack_timer_ =
+      scheduler_->post(ack_delay, [this, token]() { flushAck(token); });
+}
+
+void PerfectLink::flushAck(uint64_t token) {
+  std::string ack_msg;
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    if (token != ack_token_) {
+      // The acknowledgement has been sent in the meantime.
+      return;
     }
-    {
-      std::unique_lock<std::shared_timed_mutex> lock(mutex_);
-      undelivered_messages_.erase(id);
+    ack_timer_ = executor::TimerHandle();
+    ack_msg = takeAck();
+  }
+  if (!ack_msg.empty()) {
+    transmit(ack_msg);
+  }
+}
+
+void PerfectLink::handleAck(util::BytesView msg) {
+  const uint32_t recv_next = LinkAck::RecvNext::load(msg.data());
+  const uint64_t bitmap = LinkAck::Bitmap::load(msg.data());
+  std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+  const auto now = std::chrono::high_resolution_clock::now();
+  // Karn's rule: the ack of a retransmitted message cannot be matched to a
+  // particular transmission and hence, does not yield a sample. The earliest
+  // of the acknowledged messages waited the longest for the acknowledgement,
+  // so the sample covers the time the acknowledgement was held back.
+  bool has_sample = false;
+  TimePoint earliest_sent;
+  const auto acknowledge = [&](std::map<uint32_t, Unacked>::iterator it) {
+    if (it->second.transmissions == 1 &&
+        (!has_sample || it->second.sent < earliest_sent)) {
+      earliest_sent = it->second.sent;
+      has_sample = true;
+    }
+    deadlines_.erase({it->second.deadline, it->first});
+    return undelivered_messages_.erase(it);
+  };
+  auto it = undelivered_messages_.begin();
+  while (it != undelivered_messages_.end() && it->first < recv_next) {
+    it = acknowledge(it);
+  }
+  for (int bit = 0; bit < sack_bits; bit++) {
+    if (!(bitmap & (uint64_t(1) << bit))) {
+      continue;
     }
+    it = undelivered_messages_.find(recv_next + 1 + bit);
+    if (it != undelivered_messages_.end()) {
+      acknowledge(it);
+    }
+  }
+  if (has_sample) {
+    sampleRoundTripTime(
+        std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                              earliest_sent));
+  }
+  // Messages received past the first missing one tell that it is most likely
+  // lost. It is retransmitted right away, at most once per smoothed round
+  // trip, rather than after its backed off timeout since none of the messages
+  // more than `sack_bits` past it can be acknowledged until it arrives. Until
+  // the round trip time has been sampled, the hole waits for its timeout.
+  std::string lost_msg;
+  it = undelivered_messages_.find(recv_next);
+  if (bitmap != 0 && has_rtt_sample_ && it != undelivered_messages_.end() &&
+      now - it->second.sent >= srtt_) {
+    auto& unacked = it->second;
+    deadlines_.erase({unacked.deadline, it->first});
+    unacked.transmissions += 1;
+    unacked.sent = now;
+    unacked.deadline = now + getTimeout(unacked.transmissions);
+    deadlines_.insert({unacked.deadline, it->first});
+    armSweepTimer(now);
+    lost_msg = unacked.msg;
+  }
+  // Nothing is left to be retransmitted. Do not wake up for nothing.
+  if (undelivered_messages_.empty() && sweep_timer_.isValid()) {
+    scheduler_->cancel(sweep_timer_);
+    sweep_timer_ = executor::TimerHandle();
+  }
+  lock.unlock();
+  if (!lost_msg.empty()) {
+    transmit(lost_msg);
+  }
+}
+
+bool PerfectLink::recvMessage(util::BytesView msg) {
+  if (isAckMessage(msg)) {
+    handleAck(msg);
     return false;
   }
-  ackMessage(msg);
-  // This message might be a new one.
-  int id = identity_manager_.assignId(msg);
-  std::unique_lock<std::shared_timed_mutex> lock(mutex_);
-  if (delivered_messages_.find(id) != delivered_messages_.end()) {
-    // We have already received this message.
+  if (msg.size() < min_length) {
     return false;
   }
-  delivered_messages_.insert(id);
-  return true;
+  bool is_new;
+  std::string ack_msg;
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+    // A duplicate is acknowledged as well since the foreign process might
+    // have missed the acknowledgement. A message too far ahead for the window
+    // is dropped and left to be retransmitted.
+    is_new = received_.insert(LinkHeader::Seq::load(msg.data()));
+    unacked_count_ += 1;
+    if (unacked_count_ >= ack_threshold) {
+      ack_msg = takeAck();
+    } else {
+      armAckTimer();
+    }
+  }
+  if (!ack_msg.empty()) {
+    transmit(ack_msg);
+  }
+  return is_new;
 }
 
 }  // namespace link
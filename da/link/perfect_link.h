@@ -2,70 +2,194 @@
 #define __INCLUDED_DA_LINK_PERFECT_LINK_H_
 
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
+#include <random>
+#include <set>
 #include <shared_mutex>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <utility>
 
 #include <da/executor/scheduler.h>
 #include <da/process/process.h>
-#include <da/socket/udp_socket.h>
-#include <da/util/identity_manager.h>
+#include <da/transmitter/transmitter.h>
+#include <da/util/bytes_view.h>
+#include <da/util/sequence_window.h>
 #include <da/util/status.h>
 #include <da/util/statusor.h>
+#include <da/util/wire.h>
 
 namespace da {
 namespace link {
 
 extern const int max_length;
-extern const int min_length;
 
+// The header that precedes the payload of every message sent over a link.
+struct LinkHeader {
+  using SenderId = util::Field<uint16_t, 0>;
+  // Set for acknowledgements.
+  using IsAck = util::Field<uint8_t, SenderId::end>;
+  using Seq = util::Field<uint32_t, IsAck::end>;
+  static constexpr int size = Seq::end;
+};
+
+// An acknowledgement, which shares the header of the messages.
+struct LinkAck {
+  // Denotes the first sequence number that has not been received.
+  using RecvNext = LinkHeader::Seq;
+  // Denotes the receipt of the messages following `RecvNext`, one bit each.
+  using Bitmap = util::Field<uint64_t, LinkHeader::size>;
+  static constexpr int size = Bitmap::end;
+};
+
+// Denotes the length of the header that precedes the payload of a message.
+constexpr int min_length = LinkHeader::size;
+// Denotes the length of an acknowledgement.
+constexpr int ack_length = LinkAck::size;
+
+// Returns whether the link message is an acknowledgement.
+bool isAckMessage(util::BytesView msg);
+
+// Every message sent over a link carries a sequence number of the link. The
+// foreign process acknowledges all the messages received below the first one
+// that is missing at once, along with a bitmap of the ones received after it.
+// Acknowledgements are held back for a short while so that they cover more
+// messages, unless they can ride along with a message to the foreign process.
 class PerfectLink {
  public:
-  PerfectLink(executor::Scheduler* scheduler, socket::UDPSocket* sock,
+  PerfectLink(executor::Scheduler* scheduler,
+              transmitter::Transmitter* transmitter,
               const process::Process* local_process,
               const process::Process* foreign_process);
 
-  PerfectLink(executor::Scheduler* scheduler, socket::UDPSocket* sock,
+  PerfectLink(executor::Scheduler* scheduler,
+              transmitter::Transmitter* transmitter,
               const process::Process* local_process,
               const process::Process* foreign_process,
               std::chrono::microseconds interval);
 
+  // The retransmission timeout starts at `initial_rto` and adapts to the round
+  // trip time measured from the acknowledgements, staying within `min_rto` and
+  // `max_rto`.
+  PerfectLink(executor::Scheduler* scheduler,
+              transmitter::Transmitter* transmitter,
+              const process::Process* local_process,
+              const process::Process* foreign_process,
+              std::chrono::microseconds initial_rto,
+              std::chrono::microseconds min_rto,
+              std::chrono::microseconds max_rto);
+
   ~PerfectLink();
 
-  // Sends a message containing the given message id to the foreign process.
+  // Sends the message to the foreign process under the next sequence number.
   void sendMessage(const std::string* msg);
 
+  // Adds the message to the window of unacknowledged messages under the given
+  // sequence number without sending it so that the caller can send it by other
+  // means, e.g. multicast. The message is retransmitted to the foreign process
+  // like any other until it is acknowledged. Returns the bytes to be sent.
+  //
+  // The caller numbers the messages from zero without gaps and must not mix
+  // this with `sendMessage`.
+  std::string stageMessage(const std::string* msg, uint32_t seq);
+
   // Receives the provided message at the level of perfect links.
-  bool recvMessage(const std::string& msg);
+  bool recvMessage(util::BytesView msg);
 
  private:
-  // Schedules a callback to send message periodically until an ack is
-  // received.
-  void sendMessageCallback(int id);
+  using TimePoint = std::chrono::time_point<std::chrono::high_resolution_clock>;
+
+  // Denotes a message sent to foreign process that has not been acknowledged
+  // yet.
+  struct Unacked {
+    // The message as sent, i.e., along with the header.
+    std::string msg;
+    // Denotes the time at which the message was last sent.
+    TimePoint sent;
+    // Denotes the time after which the message is retransmitted.
+    TimePoint deadline;
+    // Denotes the number of times the message has been sent.
+    int transmissions;
+  };
+
+  // Adds the message to the window under the given sequence number. Returns
+  // the bytes to be sent. Assumes that the lock is held.
+  const std::string& trackMessage(const std::string* msg, uint32_t seq);
+
+  // Sends the given bytes to the foreign process once.
+  void transmit(const std::string& msg);
+
+  // Retransmits the messages whose deadline has expired. Invoked by the sweep
+  // timer that was armed with the given token.
+  void sweep(uint64_t token);
+
+  // Arms the sweep timer for the earliest deadline unless it is already armed
+  // for an earlier time. Assumes that the lock is held.
+  void armSweepTimer(TimePoint now);
+
+  // Returns the timeout of a message that has been sent the given number of
+  // times. The timeout doubles on every retransmission and is jittered so that
+  // the retransmissions of different links do not synchronize. Assumes that
+  // the lock is held.
+  std::chrono::microseconds getTimeout(int transmissions);
+
+  // Updates the retransmission timeout with a round trip time sample. Assumes
+  // that the lock is held.
+  void sampleRoundTripTime(std::chrono::microseconds rtt);
+
+  // Removes the messages covered by the acknowledgement from the window and
+  // retransmits the first missing message if it appears to be lost.
+  void handleAck(util::BytesView msg);
+
+  // Returns the acknowledgement of all the messages received so far, or an
+  // empty string if nothing is left to be acknowledged, and disarms the ack
+  // timer. Assumes that the lock is held.
+  std::string takeAck();
 
-  // Sends an acknowledgement when of the received message.
-  void ackMessage(const std::string& msg);
+  // Arms the ack timer unless it is already armed. Assumes that the lock is
+  // held.
+  void armAckTimer();
 
-  // Constructs and returns a unique identity for the given message.
-  int constructIdentity(const std::string* msg);
+  // Sends the pending acknowledgement. Invoked by the ack timer that was armed
+  // with the given token.
+  void flushAck(uint64_t token);
 
   executor::Scheduler* scheduler_;
-  socket::UDPSocket* sock_;
+  transmitter::Transmitter* transmitter_;
   const process::Process* local_process_;
   const process::Process* foreign_process_;
-  const std::chrono::microseconds interval_;
+  const std::chrono::microseconds min_rto_;
+  const std::chrono::microseconds max_rto_;
+  // The retransmission timeout derived from the smoothed round trip time and
+  // its variation as per Jacobson/Karels.
+  std::chrono::microseconds rto_;
+  std::chrono::microseconds srtt_;
+  std::chrono::microseconds rttvar_;
+  bool has_rtt_sample_;
+  // Used to jitter the timeouts.
+  std::minstd_rand random_engine_;
   std::shared_timed_mutex mutex_;
-  // Used to assign a unique identity to messages at the current layer.
-  util::IdentityManager<std::string> identity_manager_;
-  // Denotes the set of messages sent to foreign process that have not been
-  // acknowledged yet.
-  std::unordered_set<int> undelivered_messages_;
-  // Denotes the set of messages received from foreign process that have not
-  // been acknowledged yet.
-  std::unordered_set<int> delivered_messages_;
+  // Denotes the sequence number of the next message sent by `sendMessage`.
+  uint32_t next_seq_;
+  // The window of messages sent to foreign process that have not been
+  // acknowledged yet by their sequence number.
+  std::map<uint32_t, Unacked> undelivered_messages_;
+  // The unacknowledged messages in the order of their deadline.
+  std::set<std::pair<TimePoint, uint32_t>> deadlines_;
+  // A single timer per link retransmits all the expired messages.
+  executor::TimerHandle sweep_timer_;
+  TimePoint sweep_time_;
+  // Identifies the latest armed sweep timer so that a stale one does nothing.
+  uint64_t sweep_token_;
+  // The sequence numbers of the messages received from foreign process.
+  util::SequenceWindow received_;
+  // Denotes the number of messages received since the last acknowledgement.
+  int unacked_count_;
+  executor::TimerHandle ack_timer_;
+  // Identifies the latest armed ack timer so that a stale one does nothing.
+  uint64_t ack_token_;
 };
 
 }  // namespace link
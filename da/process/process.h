@@ -1,6 +1,7 @@
 #ifndef __INCLUDED_DA_PROCESS_PROCESS_H_
 #define __INCLUDED_DA_PROCESS_PROCESS_H_
 
+#include <netinet/in.h>
 #include <algorithm>
 #include <ostream>
 #include <string>
@@ -11,11 +12,12 @@ namespace process {
 
 class Process {
  public:
-  Process(int id, std::string ip_addr, int port, int message_count,
-          bool current = false)
+  Process(int id, std::string ip_addr, int port, const sockaddr_in& addr,
+          int message_count, bool current = false)
       : id_(id),
         ip_addr_(std::move(ip_addr)),
         port_(port),
+        addr_(addr),
         message_count_(message_count),
         current_(current) {}
 
@@ -25,6 +27,10 @@ class Process {
 
   int getPort() const { return port_; }
 
+  // Denotes the address and port resolved in advance so that sending to this
+  // process does not need to parse them every time.
+  const sockaddr_in& getAddr() const { return addr_; }
+
   int getMessageCount() const { return message_count_; }
 
   bool isCurrent() const { return current_; }
@@ -47,6 +53,7 @@ class Process {
   const int id_;
   const std::string ip_addr_;
   const int port_;
+  const sockaddr_in addr_;
   // Denotes the number of messages this process has to broadcast.
   const int message_count_;
   // Denotes if this process is the one that is actually running.
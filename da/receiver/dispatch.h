@@ -0,0 +1,62 @@
+#ifndef __INCLUDED_DA_RECEIVER_DISPATCH_H_
+#define __INCLUDED_DA_RECEIVER_DISPATCH_H_
+
+#include <cstdint>
+
+#include <da/broadcast/uniform_reliable.h>
+#include <da/executor/executor.h>
+#include <da/link/perfect_link.h>
+#include <da/transmitter/frame.h>
+#include <da/util/buffer_pool.h>
+#include <da/util/bytes_view.h>
+#include <da/util/logging.h>
+#include <da/util/util.h>
+
+namespace da {
+namespace receiver {
+
+// Returns the id of the process that broadcasted the message. Assumes that the
+// message has a valid minimum length.
+inline unsigned int unpackOriginId(const char* msg) {
+  return broadcast::UrbHeader::OriginId::load(msg + link::min_length);
+}
+
+// Returns the id of the process that sent the message over the link.
+inline unsigned int unpackSenderId(const char* msg) {
+  return link::LinkHeader::SenderId::load(msg);
+}
+
+// Hands every acknowledgement and every message of at least `min_length` bytes
+// packed in the frame of `length` bytes over to `deliver`. Messages from the
+// same origin are delivered by the same worker so that they are not reordered
+// on their way to the FIFO layer. The messages share the buffer of the frame,
+// which goes back to the pool once the last of them has been delivered.
+template <typename Deliver>
+void dispatchFrame(executor::Executor* executor,
+                   const util::PooledBuffer& buffer, int length, int min_length,
+                   Deliver deliver) {
+  const char* frame = buffer.data();
+  const bool ok = transmitter::forEachMessage(
+      frame, length, [&](int offset, int msg_length) {
+        const bool is_ack =
+            link::isAckMessage(util::BytesView(frame + offset, msg_length));
+        if (!is_ack && msg_length < min_length) {
+          LOG("Unable to receive a message of length atleast ", min_length,
+              ". Received length: ", msg_length);
+          return;
+        }
+        const unsigned int key = is_ack ? unpackSenderId(frame + offset)
+                                        : unpackOriginId(frame + offset);
+        executor->post(key, [deliver, buffer, offset, msg_length]() {
+          deliver(util::BytesView(buffer.data() + offset, msg_length));
+        });
+      });
+  if (!ok) {
+    LOG("Received a malformed frame of length ", length);
+  }
+}
+
+}  // namespace receiver
+}  // namespace da
+
+#endif  // __INCLUDED_DA_RECEIVER_DISPATCH_H_
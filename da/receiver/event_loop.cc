@@ -0,0 +1,133 @@
+#include <da/receiver/event_loop.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <utility>
+
+#include <da/util/logging.h>
+
+namespace da {
+namespace receiver {
+namespace {
+
+// Denotes the maximum number of events handled per wake up.
+const int max_events = 16;
+
+}  // namespace
+
+EventLoop::EventLoop() throw() : alive_(true) {
+  if ((epoll_fd_ = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+    throw util::RuntimeStatusError(
+        util::Status(util::StatusCode::kUnknown,
+                     "Event loop creation failed (epoll_create1())"));
+  }
+  if ((event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0) {
+    close(epoll_fd_);
+    throw util::RuntimeStatusError(util::Status(
+        util::StatusCode::kUnknown, "Event loop creation failed (eventfd())"));
+  }
+  // The wake up event carries no handler.
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &event) < 0) {
+    close(event_fd_);
+    close(epoll_fd_);
+    throw util::RuntimeStatusError(
+        util::Status(util::StatusCode::kUnknown,
+                     "Event loop creation failed (epoll_ctl())"));
+  }
+}
+
+EventLoop::~EventLoop() {
+  for (const auto& handler : handlers_) {
+    if (handler->is_timer) {
+      close(handler->fd);
+    }
+  }
+  close(event_fd_);
+  close(epoll_fd_);
+}
+
+util::Status EventLoop::addReader(int fd, std::function<void()> on_readable) {
+  return addHandler(std::unique_ptr<Handler>(
+      new Handler{fd, false, std::move(on_readable)}));
+}
+
+util::Status EventLoop::addTimer(std::chrono::microseconds interval,
+                                 std::function<void()> on_expiry) {
+  const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+  if (fd < 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Timer creation failed (timerfd_create())");
+  }
+  itimerspec spec = {};
+  spec.it_interval.tv_sec = interval.count() / 1000000;
+  spec.it_interval.tv_nsec = (interval.count() % 1000000) * 1000;
+  spec.it_value = spec.it_interval;
+  if (timerfd_settime(fd, 0, &spec, nullptr) < 0) {
+    close(fd);
+    return util::Status(util::StatusCode::kUnknown,
+                        "Timer creation failed (timerfd_settime())");
+  }
+  const auto status = addHandler(
+      std::unique_ptr<Handler>(new Handler{fd, true, std::move(on_expiry)}));
+  if (!status.ok()) {
+    close(fd);
+  }
+  return status;
+}
+
+util::Status EventLoop::addHandler(std::unique_ptr<Handler> handler) {
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.ptr = handler.get();
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, handler->fd, &event) < 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Registration with event loop failed (epoll_ctl())");
+  }
+  handlers_.push_back(std::move(handler));
+  return util::Status();
+}
+
+void EventLoop::run() {
+  epoll_event events[max_events];
+  while (isAlive()) {
+    const int count = epoll_wait(epoll_fd_, events, max_events, -1);
+    if (count < 0) {
+      if (errno != EINTR) {
+        LOG("Waiting for events failed (epoll_wait()). Errno: ", errno);
+      }
+      continue;
+    }
+    for (int i = 0; i < count && isAlive(); i++) {
+      auto handler = static_cast<Handler*>(events[i].data.ptr);
+      if (handler == nullptr) {
+        // Woken up by stop.
+        continue;
+      }
+      if (handler->is_timer) {
+        uint64_t expirations;
+        if (read(handler->fd, &expirations, sizeof(expirations)) < 0) {
+          continue;
+        }
+      }
+      handler->callback();
+    }
+  }
+}
+
+void EventLoop::stop() {
+  alive_ = false;
+  const uint64_t one = 1;
+  if (write(event_fd_, &one, sizeof(one)) < 0) {
+    LOG("Waking up the event loop failed (write()). Errno: ", errno);
+  }
+}
+
+}  // namespace receiver
+}  // namespace da
@@ -0,0 +1,64 @@
+#ifndef __INCLUDED_DA_RECEIVER_EVENT_LOOP_H_
+#define __INCLUDED_DA_RECEIVER_EVENT_LOOP_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <da/util/status.h>
+
+namespace da {
+namespace receiver {
+
+// An epoll based event loop that calls back whenever one of its descriptors is
+// readable or one of its timers expires. Stopping the loop from any thread
+// wakes it up right away through an eventfd.
+//
+// Readers and timers must be added before the loop is run.
+class EventLoop {
+ public:
+  EventLoop() throw();
+
+  ~EventLoop();
+
+  // Delete the copy constructor.
+  EventLoop(const EventLoop&) = delete;
+  // Delete the copy assignment operator.
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  // Calls `on_readable` from the loop as long as the descriptor is readable.
+  util::Status addReader(int fd, std::function<void()> on_readable);
+
+  // Calls `on_expiry` from the loop every `interval`.
+  util::Status addTimer(std::chrono::microseconds interval,
+                        std::function<void()> on_expiry);
+
+  // Dispatches the events until the loop is stopped.
+  void run();
+
+  void stop();
+
+  bool isAlive() const { return alive_; }
+
+ private:
+  struct Handler {
+    int fd;
+    // Set for timers whose expirations have to be read before calling back.
+    bool is_timer;
+    std::function<void()> callback;
+  };
+
+  util::Status addHandler(std::unique_ptr<Handler> handler);
+
+  std::atomic<bool> alive_;
+  int epoll_fd_;
+  int event_fd_;
+  std::vector<std::unique_ptr<Handler>> handlers_;
+};
+
+}  // namespace receiver
+}  // namespace da
+
+#endif  // __INCLUDED_DA_RECEIVER_EVENT_LOOP_H_
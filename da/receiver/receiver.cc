@@ -1,58 +1,63 @@
 #include <da/receiver/receiver.h>
 
-#include <memory>
 #include <string>
 
+#include <da/receiver/dispatch.h>
 #include <da/util/logging.h>
 
 namespace da {
 namespace receiver {
+namespace {
+
+// Denotes the maximum number of datagrams received with a single system call.
+const int batch_size = 64;
+
+}  // namespace
 
 void Receiver::operator()(broadcast::UniformFIFOReliable* fifo_urb) {
-  while (isAlive()) {
-    auto buffer = std::make_unique<char[]>(broadcast::fifo_min_length);
-    const auto int_or = sock_->recv(buffer.get(), broadcast::fifo_min_length);
+  socket::DatagramBatch batch(batch_size, pool_);
+  const int fd = sock_->getPollDescriptor();
+  const auto status = event_loop_.addReader(fd, [this, fifo_urb, &batch]() {
+    const auto int_or = sock_->recvBatch(batch, false);
     if (!int_or.ok()) {
       LOG("Receiving from the socket failed. Status: ", int_or.status());
-      continue;
+      return;
     }
-    if (int_or.value() < broadcast::fifo_min_length) {
-      LOG("Unable to receive a message of length atleast ",
-          broadcast::fifo_min_length,
-          " from the socket. Received length: ", int_or.value());
-      continue;
+    for (int i = 0; i < batch.size(); i++) {
+      dispatchFrame(executor_, batch.takeBuffer(i), batch.getLength(i),
+                    broadcast::fifo_min_length,
+                    [fifo_urb](util::BytesView msg) {
+                      fifo_urb->deliver(msg);
+                    });
     }
-    std::string msg(buffer.get(), int_or.value());
-    if (!isAlive()) {
-      break;
-    }
-    executor_->add([&fifo_urb, msg = std::move(msg)]() {
-      fifo_urb->deliver(std::move(msg));
-    });
+  });
+  if (!status.ok()) {
+    LOG("Unable to poll the socket. Status: ", status);
+    return;
   }
+  event_loop_.run();
 }
 
 void Receiver::operator()(broadcast::UniformLocalizedCausal* lc_urb) {
-  while (isAlive()) {
-    auto buffer = std::make_unique<char[]>(broadcast::lcb_max_length);
-    const auto int_or = sock_->recv(buffer.get(), broadcast::lcb_max_length);
+  socket::DatagramBatch batch(batch_size, pool_);
+  const int fd = sock_->getPollDescriptor();
+  const auto status = event_loop_.addReader(fd, [this, lc_urb, &batch]() {
+    const auto int_or = sock_->recvBatch(batch, false);
     if (!int_or.ok()) {
       LOG("Receiving from the socket failed. Status: ", int_or.status());
-      continue;
-    }
-    if (int_or.value() < broadcast::lcb_min_length) {
-      LOG("Unable to receive a message of length atleast ",
-          broadcast::lcb_min_length,
-          " from the socket. Received length: ", int_or.value());
-      continue;
+      return;
     }
-    std::string msg(buffer.get(), int_or.value());
-    if (!isAlive()) {
-      break;
+    for (int i = 0; i < batch.size(); i++) {
+      dispatchFrame(executor_, batch.takeBuffer(i), batch.getLength(i),
+                    broadcast::lcb_min_length,
+                    [lc_urb](util::BytesView msg) { lc_urb->deliver(msg); });
     }
-    executor_->add(
-        [&lc_urb, msg = std::move(msg)]() { lc_urb->deliver(std::move(msg)); });
+  });
+  if (!status.ok()) {
+    LOG("Unable to poll the socket. Status: ", status);
+    return;
   }
+  event_loop_.run();
 }
 
 }  // namespace receiver
@@ -7,22 +7,37 @@
 #include <da/broadcast/localized_causal.h>
 #include <da/executor/executor.h>
 #include <da/link/perfect_link.h>
+#include <da/receiver/event_loop.h>
 #include <da/socket/udp_socket.h>
+#include <da/util/buffer_pool.h>
 
 namespace da {
 namespace receiver {
 
+// Receives the datagrams from an event loop. The loop can be used to poll more
+// sockets or timers on the same thread.
+//
+// Datagrams are received into the buffers of the pool and handed to the
+// protocol layers without being copied. A buffer goes back to the pool once
+// the message has been delivered.
 class Receiver {
  public:
-  Receiver(executor::Executor* executor, socket::UDPSocket* sock)
-      : alive_(true), executor_(executor), sock_(sock) {}
+  Receiver(executor::Executor* executor, socket::UDPSocket* sock,
+           util::BufferPool* pool)
+      : alive_(true), executor_(executor), sock_(sock), pool_(pool) {}
 
   ~Receiver() { stop(); }
 
-  void stop() { alive_ = false; }
+  // Wakes up the receiving thread right away.
+  void stop() {
+    alive_ = false;
+    event_loop_.stop();
+  }
 
   bool isAlive() const { return alive_; }
 
+  EventLoop* getEventLoop() { return &event_loop_; }
+
   void operator()(broadcast::UniformFIFOReliable* fifo_urb);
 
   void operator()(broadcast::UniformLocalizedCausal* lc_urb);
@@ -31,6 +46,8 @@ class Receiver {
   std::atomic<bool> alive_;
   executor::Executor* executor_;
   socket::UDPSocket* sock_;
+  util::BufferPool* pool_;
+  EventLoop event_loop_;
 };
 
 }  // namespace receiver
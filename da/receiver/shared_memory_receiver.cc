@@ -0,0 +1,53 @@
+#include <da/receiver/shared_memory_receiver.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <da/receiver/dispatch.h>
+#include <da/util/bytes_view.h>
+#include <da/util/logging.h>
+
+namespace da {
+namespace receiver {
+namespace {
+
+// Denotes the maximum number of datagrams handed over per drain.
+const int batch_size = 64;
+// Bounds the sleep in case a wake up is missed.
+const std::chrono::microseconds max_wait(100000);
+
+}  // namespace
+
+template <typename Deliver>
+void SharedMemoryReceiver::run(int min_length, Deliver deliver) {
+  const auto on_datagram = [this, min_length, &deliver](const char* data,
+                                                        int length) {
+    length = std::min(length, pool_->getBufferSize());
+    util::PooledBuffer buffer = pool_->acquire();
+    memcpy(buffer.data(), data, length);
+    dispatchFrame(executor_, buffer, length, min_length, deliver);
+  };
+  while (isAlive()) {
+    const uint32_t doorbell = inbox_->getDoorbell();
+    if (inbox_->drain(on_datagram, batch_size) > 0) {
+      continue;
+    }
+    inbox_->wait(doorbell, max_wait);
+  }
+}
+
+void SharedMemoryReceiver::operator()(
+    broadcast::UniformFIFOReliable* fifo_urb) {
+  run(broadcast::fifo_min_length,
+      [fifo_urb](util::BytesView msg) { fifo_urb->deliver(msg); });
+}
+
+void SharedMemoryReceiver::operator()(
+    broadcast::UniformLocalizedCausal* lc_urb) {
+  run(broadcast::lcb_min_length,
+      [lc_urb](util::BytesView msg) { lc_urb->deliver(msg); });
+}
+
+}  // namespace receiver
+}  // namespace da
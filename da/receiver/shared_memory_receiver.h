@@ -0,0 +1,53 @@
+#ifndef __INCLUDED_DA_RECEIVER_SHARED_MEMORY_RECEIVER_H_
+#define __INCLUDED_DA_RECEIVER_SHARED_MEMORY_RECEIVER_H_
+
+#include <atomic>
+
+#include <da/broadcast/fifo.h>
+#include <da/broadcast/localized_causal.h>
+#include <da/executor/executor.h>
+#include <da/shm/shared_memory.h>
+#include <da/util/buffer_pool.h>
+
+namespace da {
+namespace receiver {
+
+// Receives the datagrams published to the shared memory inbox of the process
+// by the processes on the same host. The datagrams are copied into the buffers
+// of the pool so that the rings can be reused right away.
+class SharedMemoryReceiver {
+ public:
+  SharedMemoryReceiver(executor::Executor* executor, shm::Inbox* inbox,
+                       util::BufferPool* pool)
+      : alive_(true), executor_(executor), inbox_(inbox), pool_(pool) {}
+
+  ~SharedMemoryReceiver() { stop(); }
+
+  // Wakes up the receiving thread right away.
+  void stop() {
+    alive_ = false;
+    inbox_->wake();
+  }
+
+  bool isAlive() const { return alive_; }
+
+  void operator()(broadcast::UniformFIFOReliable* fifo_urb);
+
+  void operator()(broadcast::UniformLocalizedCausal* lc_urb);
+
+ private:
+  // Drains the inbox until stopped, handing over every datagram of at least
+  // `min_length` bytes.
+  template <typename Deliver>
+  void run(int min_length, Deliver deliver);
+
+  std::atomic<bool> alive_;
+  executor::Executor* executor_;
+  shm::Inbox* inbox_;
+  util::BufferPool* pool_;
+};
+
+}  // namespace receiver
+}  // namespace da
+
+#endif  // __INCLUDED_DA_RECEIVER_SHARED_MEMORY_RECEIVER_H_
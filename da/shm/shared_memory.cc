@@ -0,0 +1,325 @@
+#include <da/shm/shared_memory.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <climits>
+#include <cstring>
+#include <new>
+
+namespace da {
+namespace shm {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Atomics shared between processes must be lock-free");
+
+struct SegmentHeader {
+  uint32_t magic;
+  int32_t pid;
+  uint32_t num_rings;
+  uint32_t ring_capacity;
+  // Set once the segment is initialized and unset once the consumer is gone.
+  std::atomic<uint32_t> ready;
+  // The futex word the consumer sleeps on. Bumped on every notification.
+  alignas(64) std::atomic<uint32_t> doorbell;
+  std::atomic<uint32_t> sleeping;
+};
+
+// The producer and the consumer own a cache line each. The bytes of the ring
+// follow the header.
+struct RingHeader {
+  alignas(64) std::atomic<uint64_t> write_pos;
+  alignas(64) std::atomic<uint64_t> read_pos;
+};
+
+namespace {
+
+const uint32_t segment_magic = 0xDA5E6D01;
+// Marks the unused end of the ring that a record did not fit in.
+const uint32_t padding_marker = 0xFFFFFFFF;
+// Every record is a 32-bit length followed by the bytes and aligned to 8.
+const int record_header_size = sizeof(uint32_t);
+const int record_alignment = 8;
+const std::chrono::milliseconds reopen_interval(100);
+
+std::size_t roundUp(std::size_t x, std::size_t multiple) {
+  return (x + multiple - 1) / multiple * multiple;
+}
+
+uint64_t getRecordSize(int length) {
+  return roundUp(record_header_size + length, record_alignment);
+}
+
+std::size_t getHeaderSize() { return roundUp(sizeof(SegmentHeader), 64); }
+
+std::size_t getRingStride(uint32_t ring_capacity) {
+  return sizeof(RingHeader) + ring_capacity;
+}
+
+RingHeader* getRingAt(void* segment, uint32_t ring_capacity, int i) {
+  return reinterpret_cast<RingHeader*>(static_cast<char*>(segment) +
+                                       getHeaderSize() +
+                                       i * getRingStride(ring_capacity));
+}
+
+char* getRingData(RingHeader* ring) {
+  return reinterpret_cast<char*>(ring + 1);
+}
+
+uint32_t* toFutex(std::atomic<uint32_t>* word) {
+  return reinterpret_cast<uint32_t*>(word);
+}
+
+}  // namespace
+
+std::string getSegmentName(const std::string& ip_addr, unsigned short port) {
+  return "/da_proc_" + ip_addr + "_" + std::to_string(port);
+}
+
+Inbox::Inbox(const std::string& name)
+    : name_(name),
+      fd_(-1),
+      segment_(MAP_FAILED),
+      segment_size_(0),
+      header_(nullptr),
+      next_ring_(0) {}
+
+Inbox::~Inbox() {
+  if (header_ != nullptr) {
+    header_->ready.store(0, std::memory_order_release);
+    wake();
+  }
+  if (segment_ != MAP_FAILED) {
+    munmap(segment_, segment_size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    shm_unlink(name_.c_str());
+  }
+}
+
+util::Status Inbox::init(int num_rings, int ring_capacity) {
+  // A segment left behind by a crashed process of the same name is stale.
+  shm_unlink(name_.c_str());
+  if ((fd_ = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)) < 0) {
+    return util::Status(util::StatusCode::kUnavailable,
+                        "Segment creation failed (shm_open())");
+  }
+  const uint32_t capacity = roundUp(ring_capacity, 64);
+  segment_size_ = getHeaderSize() + num_rings * getRingStride(capacity);
+  if (ftruncate(fd_, segment_size_) < 0) {
+    return util::Status(util::StatusCode::kUnavailable,
+                        "Segment sizing failed (ftruncate())");
+  }
+  segment_ = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  fd_, 0);
+  if (segment_ == MAP_FAILED) {
+    return util::Status(util::StatusCode::kUnavailable,
+                        "Segment mapping failed (mmap())");
+  }
+  header_ = new (segment_) SegmentHeader;
+  header_->magic = segment_magic;
+  header_->pid = getpid();
+  header_->num_rings = num_rings;
+  header_->ring_capacity = capacity;
+  header_->doorbell.store(0, std::memory_order_relaxed);
+  header_->sleeping.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < num_rings; i++) {
+    RingHeader* ring = new (getRing(i)) RingHeader;
+    ring->write_pos.store(0, std::memory_order_relaxed);
+    ring->read_pos.store(0, std::memory_order_relaxed);
+  }
+  // Publish the segment to the producers.
+  header_->ready.store(1, std::memory_order_release);
+  return util::Status();
+}
+
+int Inbox::drain(const std::function<void(const char*, int)>& on_datagram,
+                 int max_count) {
+  const int num_rings = header_->num_rings;
+  const uint64_t capacity = header_->ring_capacity;
+  int count = 0;
+  for (int k = 0; k < num_rings && count < max_count; k++) {
+    RingHeader* ring = getRing((next_ring_ + k) % num_rings);
+    char* data = getRingData(ring);
+    uint64_t read = ring->read_pos.load(std::memory_order_relaxed);
+    const uint64_t write = ring->write_pos.load(std::memory_order_acquire);
+    while (read < write && count < max_count) {
+      const uint64_t offset = read % capacity;
+      uint32_t length;
+      memcpy(&length, data + offset, sizeof(length));
+      if (length == padding_marker) {
+        read += capacity - offset;
+        continue;
+      }
+      on_datagram(data + offset + record_header_size, length);
+      read += getRecordSize(length);
+      count += 1;
+    }
+    // Hand the space back to the producer.
+    ring->read_pos.store(read, std::memory_order_release);
+  }
+  next_ring_ = (next_ring_ + 1) % num_rings;
+  return count;
+}
+
+uint32_t Inbox::getDoorbell() const {
+  return header_->doorbell.load(std::memory_order_acquire);
+}
+
+void Inbox::wait(uint32_t doorbell, std::chrono::microseconds timeout) {
+  header_->sleeping.store(1);
+  // Pairs with the producer that publishes and then checks for a sleeper.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!hasPending()) {
+    timespec spec;
+    spec.tv_sec = timeout.count() / 1000000;
+    spec.tv_nsec = (timeout.count() % 1000000) * 1000;
+    syscall(SYS_futex, toFutex(&header_->doorbell), FUTEX_WAIT, doorbell,
+            &spec, nullptr, 0);
+  }
+  header_->sleeping.store(0, std::memory_order_relaxed);
+}
+
+void Inbox::wake() {
+  header_->doorbell.fetch_add(1);
+  syscall(SYS_futex, toFutex(&header_->doorbell), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+}
+
+bool Inbox::hasPending() const {
+  for (int i = 0; i < int(header_->num_rings); i++) {
+    RingHeader* ring = getRing(i);
+    if (ring->read_pos.load(std::memory_order_relaxed) !=
+        ring->write_pos.load(std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+RingHeader* Inbox::getRing(int i) const {
+  return getRingAt(segment_, header_->ring_capacity, i);
+}
+
+Outbox::Outbox(const std::string& name, int sender_id)
+    : name_(name),
+      sender_id_(sender_id),
+      segment_(MAP_FAILED),
+      segment_size_(0),
+      header_(nullptr),
+      ring_(nullptr),
+      has_pushed_(false) {}
+
+Outbox::~Outbox() { close(); }
+
+bool Outbox::push(const void* buffer, int bufferLen) {
+  if (ring_ == nullptr || header_->ready.load(std::memory_order_relaxed) != 1) {
+    close();
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_open_) {
+      return false;
+    }
+    if (!open()) {
+      next_open_ = now + reopen_interval;
+      return false;
+    }
+  }
+  const uint64_t capacity = header_->ring_capacity;
+  const uint64_t size = getRecordSize(bufferLen);
+  if (size > capacity) {
+    return false;
+  }
+  char* data = getRingData(ring_);
+  uint64_t write = ring_->write_pos.load(std::memory_order_relaxed);
+  const uint64_t read = ring_->read_pos.load(std::memory_order_acquire);
+  uint64_t offset = write % capacity;
+  // A record never wraps around. The end of the ring is skipped instead.
+  const uint64_t skipped = offset + size > capacity ? capacity - offset : 0;
+  if (write + skipped + size - read > capacity) {
+    return false;
+  }
+  if (skipped > 0) {
+    memcpy(data + offset, &padding_marker, sizeof(padding_marker));
+    write += skipped;
+    offset = 0;
+  }
+  const uint32_t length = bufferLen;
+  memcpy(data + offset, &length, sizeof(length));
+  memcpy(data + offset + record_header_size, buffer, bufferLen);
+  ring_->write_pos.store(write + size, std::memory_order_release);
+  has_pushed_ = true;
+  return true;
+}
+
+void Outbox::notify() {
+  if (!has_pushed_ || header_ == nullptr) {
+    return;
+  }
+  has_pushed_ = false;
+  header_->doorbell.fetch_add(1);
+  // Pairs with the consumer that announces its sleep and then checks for
+  // datagrams.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (header_->sleeping.load() == 1) {
+    syscall(SYS_futex, toFutex(&header_->doorbell), FUTEX_WAKE, 1, nullptr,
+            nullptr, 0);
+  }
+}
+
+bool Outbox::open() {
+  const int fd = shm_open(name_.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) < 0 ||
+      stat_buf.st_size < off_t(getHeaderSize())) {
+    ::close(fd);
+    return false;
+  }
+  void* segment = mmap(nullptr, stat_buf.st_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (segment == MAP_FAILED) {
+    return false;
+  }
+  auto header = static_cast<SegmentHeader*>(segment);
+  // The segment might still be being set up or might have been left behind by
+  // a process that is gone.
+  if (header->ready.load(std::memory_order_acquire) != 1 ||
+      header->magic != segment_magic ||
+      sender_id_ >= int(header->num_rings) ||
+      std::size_t(stat_buf.st_size) <
+          getHeaderSize() +
+              header->num_rings * getRingStride(header->ring_capacity) ||
+      (kill(header->pid, 0) < 0 && errno == ESRCH)) {
+    munmap(segment, stat_buf.st_size);
+    return false;
+  }
+  segment_ = segment;
+  segment_size_ = stat_buf.st_size;
+  header_ = header;
+  ring_ = getRingAt(segment_, header_->ring_capacity, sender_id_);
+  return true;
+}
+
+void Outbox::close() {
+  if (segment_ != MAP_FAILED) {
+    munmap(segment_, segment_size_);
+  }
+  segment_ = MAP_FAILED;
+  segment_size_ = 0;
+  header_ = nullptr;
+  ring_ = nullptr;
+  has_pushed_ = false;
+}
+
+}  // namespace shm
+}  // namespace da
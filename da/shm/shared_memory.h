@@ -0,0 +1,122 @@
+#ifndef __INCLUDED_DA_SHM_SHARED_MEMORY_H_
+#define __INCLUDED_DA_SHM_SHARED_MEMORY_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include <da/util/status.h>
+
+namespace da {
+namespace shm {
+
+// The layouts shared between the processes. Both sides must be built from the
+// same sources.
+struct SegmentHeader;
+struct RingHeader;
+
+// Returns the name of the segment of the process bound to the given address.
+std::string getSegmentName(const std::string& ip_addr, unsigned short port);
+
+// The receiving end of a process. The segment holds one single producer,
+// single consumer ring of datagrams per sending process, indexed by the id of
+// the sender. A consumer sleeping on the futex of the segment is woken up by
+// the producers once they have published datagrams.
+//
+// The inbox is not thread-safe and must be drained by one thread at a time,
+// except for `wake` which can be called from any thread.
+class Inbox {
+ public:
+  Inbox(const std::string& name);
+
+  // Unlinks the segment so that the producers fall back to the other
+  // transports.
+  ~Inbox();
+
+  // Delete the copy constructor.
+  Inbox(const Inbox&) = delete;
+  // Delete the copy assignment operator.
+  Inbox& operator=(const Inbox&) = delete;
+
+  // Creates the segment with a ring of `ring_capacity` bytes for each of the
+  // `num_rings` senders, replacing a stale segment of the same name.
+  util::Status init(int num_rings, int ring_capacity);
+
+  // Calls `on_datagram` for up to `max_count` of the published datagrams and
+  // returns the number of datagrams consumed. The bytes are only valid during
+  // the call.
+  int drain(const std::function<void(const char*, int)>& on_datagram,
+            int max_count);
+
+  // Returns the value that `wait` compares against.
+  uint32_t getDoorbell() const;
+
+  // Sleeps until a producer rings the doorbell after it had the value
+  // `doorbell`, or until the timeout expires. Returns right away if any
+  // datagram is pending.
+  void wait(uint32_t doorbell, std::chrono::microseconds timeout);
+
+  // Wakes up the consumer.
+  void wake();
+
+ private:
+  bool hasPending() const;
+
+  RingHeader* getRing(int i) const;
+
+  const std::string name_;
+  int fd_;
+  void* segment_;
+  std::size_t segment_size_;
+  SegmentHeader* header_;
+  // Denotes the ring to be drained first so that the senders are served
+  // fairly.
+  int next_ring_;
+};
+
+// The sending end towards the inbox of a peer. The segment of the peer is
+// mapped lazily since the peer might not be up yet and `push` fails until it
+// is. The outbox must only be used by one thread at a time.
+class Outbox {
+ public:
+  // Pushes into the ring of the sender with the given id.
+  Outbox(const std::string& name, int sender_id);
+
+  ~Outbox();
+
+  // Delete the copy constructor.
+  Outbox(const Outbox&) = delete;
+  // Delete the copy assignment operator.
+  Outbox& operator=(const Outbox&) = delete;
+
+  // Publishes the datagram unless the peer is not reachable or its ring is
+  // full, in which case the datagram has to take another path.
+  bool push(const void* buffer, int bufferLen);
+
+  // Wakes up the peer if it is sleeping and anything was pushed since the last
+  // notification.
+  void notify();
+
+ private:
+  bool open();
+
+  void close();
+
+  const std::string name_;
+  const int sender_id_;
+  void* segment_;
+  std::size_t segment_size_;
+  SegmentHeader* header_;
+  RingHeader* ring_;
+  bool has_pushed_;
+  // Denotes the time before which the peer's segment is not looked for again.
+  std::chrono::steady_clock::time_point next_open_;
+};
+
+}  // namespace shm
+}  // namespace da
+
+#endif  // __INCLUDED_DA_SHM_SHARED_MEMORY_H_
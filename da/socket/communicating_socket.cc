@@ -5,7 +5,7 @@
 namespace da {
 namespace socket {
 
-CommunicatingSocket::CommunicatingSocket(int type, int protocol) throw()
+CommunicatingSocket::CommunicatingSocket(int type, int protocol)
     : Socket(type, protocol) {}
 
 CommunicatingSocket::CommunicatingSocket(int sockDesc) : Socket(sockDesc) {}
@@ -18,8 +18,13 @@ util::Status CommunicatingSocket::connect(const std::string &foreignAddress,
   if (!status.ok()) {
     return status;
   }
+  return connect(destAddr);
+}
+
+util::Status CommunicatingSocket::connect(const sockaddr_in &foreignAddr) {
   // Try to connect to the given port.
-  if (::connect(sockDesc_, (sockaddr *)&destAddr, sizeof(destAddr)) < 0) {
+  if (::connect(sockDesc_, (const sockaddr *)&foreignAddr,
+                sizeof(foreignAddr)) < 0) {
     return util::Status(util::StatusCode::kUnknown,
                         "Connect failed (connect())");
   }
@@ -14,6 +14,9 @@ class CommunicatingSocket : public Socket {
   util::Status connect(const std::string& foreignAddress,
                        unsigned short foreignPort);
 
+  // Establish a socket connection with the given resolved foreign address.
+  util::Status connect(const sockaddr_in& foreignAddr);
+
   // Write the given buffer to this socket. Call connect() before calling
   // send().
   util::Status send(const void* buffer, int bufferLen);
@@ -29,7 +32,7 @@ class CommunicatingSocket : public Socket {
   util::StatusOr<unsigned short> getForeignPort();
 
  protected:
-  CommunicatingSocket(int type, int protocol) throw();
+  CommunicatingSocket(int type, int protocol);
   CommunicatingSocket(int sockDesc);
 };
 
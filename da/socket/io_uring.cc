@@ -0,0 +1,421 @@
+#include <da/socket/io_uring.h>
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <da/socket/udp_socket.h>
+
+namespace da {
+namespace socket {
+namespace {
+
+const unsigned ring_entries = 256;
+// The provided buffers. Each one holds the header of the received message,
+// the source address and the payload.
+const unsigned buffer_count = 256;
+// Large enough for a datagram that fills a jumbo frame.
+const int buffer_size = 9216;
+const int buffer_group = 0;
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete,
+                 unsigned flags) {
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                 nullptr, 0);
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg,
+                    unsigned nr_args) {
+  return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+}  // namespace
+
+IoUring::IoUring()
+    : fd_(-1),
+      sq_ring_(MAP_FAILED),
+      sq_ring_size_(0),
+      cq_ring_(MAP_FAILED),
+      cq_ring_size_(0),
+      sqes_(static_cast<io_uring_sqe*>(MAP_FAILED)),
+      sqes_size_(0),
+      sq_entries_(0),
+      sqe_tail_(0) {}
+
+IoUring::~IoUring() {
+  if (sqes_ != MAP_FAILED) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != MAP_FAILED) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+util::Status IoUring::init(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  if ((fd_ = ioUringSetup(entries, &params)) < 0) {
+    return util::Status(util::StatusCode::kUnavailable,
+                        "Ring setup failed (io_uring_setup())");
+  }
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  // Both the rings might share a single mapping.
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    return util::Status(util::StatusCode::kUnavailable,
+                        "Ring mapping failed (mmap())");
+  }
+  cq_ring_ = sq_ring_;
+  if (!single_mmap) {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return util::Status(util::StatusCode::kUnavailable,
+                          "Ring mapping failed (mmap())");
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size_,
+                                          PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_POPULATE, fd_,
+                                          IORING_OFF_SQES));
+  if (sqes_ == MAP_FAILED) {
+    return util::Status(util::StatusCode::kUnavailable,
+                        "Ring mapping failed (mmap())");
+  }
+  char* sq = static_cast<char*>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  sqe_tail_ = *sq_tail_;
+  char* cq = static_cast<char*>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  return util::Status();
+}
+
+util::Status IoUring::registerFile(int fd) {
+  if (ioUringRegister(fd_, IORING_REGISTER_FILES, &fd, 1) < 0) {
+    return util::Status(util::StatusCode::kUnavailable,
+                        "File registration failed (io_uring_register())");
+  }
+  return util::Status();
+}
+
+util::Status IoUring::registerBufferRing(io_uring_buf_ring* ring,
+                                         unsigned entries, int group) {
+  io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+  reg.ring_entries = entries;
+  reg.bgid = group;
+  if (ioUringRegister(fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    return util::Status(
+        util::StatusCode::kUnavailable,
+        "Buffer ring registration failed (io_uring_register())");
+  }
+  return util::Status();
+}
+
+io_uring_sqe* IoUring::getSqe() {
+  const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (sqe_tail_ - head >= sq_entries_) {
+    return nullptr;
+  }
+  const unsigned index = sqe_tail_ & sq_mask_;
+  sq_array_[index] = index;
+  sqe_tail_ += 1;
+  memset(&sqes_[index], 0, sizeof(io_uring_sqe));
+  return &sqes_[index];
+}
+
+util::StatusOr<int> IoUring::submitAndWait(unsigned min_complete) {
+  // Publish the entries before the kernel is told about them.
+  __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+  const unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  while (true) {
+    const unsigned to_submit =
+        sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    const int rtn = ioUringEnter(fd_, to_submit, min_complete, flags);
+    if (rtn >= 0) {
+      return rtn;
+    }
+    if (errno != EINTR) {
+      return util::Status(util::StatusCode::kUnknown,
+                          "Submission failed (io_uring_enter())");
+    }
+  }
+}
+
+int IoUring::withdrawUnsubmitted() {
+  // The kernel only takes entries in `io_uring_enter()` and thus, the tail can
+  // be moved back to the head.
+  const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  const int withdrawn = sqe_tail_ - head;
+  sqe_tail_ = head;
+  __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+  return withdrawn;
+}
+
+io_uring_cqe* IoUring::peekCqe() {
+  const unsigned head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    return nullptr;
+  }
+  return &cqes_[head & cq_mask_];
+}
+
+void IoUring::advanceCq() {
+  __atomic_store_n(cq_head_, *cq_head_ + 1, __ATOMIC_RELEASE);
+}
+
+IoUringBackend::IoUringBackend(int sockDesc)
+    : sockDesc_(sockDesc),
+      buffer_ring_(static_cast<io_uring_buf_ring*>(MAP_FAILED)),
+      buffer_ring_size_(buffer_count * sizeof(io_uring_buf)),
+      buffers_(buffer_count * buffer_size),
+      buffer_tail_(0),
+      is_receive_armed_(false) {
+  memset(&recv_msg_, 0, sizeof(recv_msg_));
+  recv_msg_.msg_namelen = sizeof(sockaddr_in);
+  // Leave room for the drop count in case the socket reports it.
+  recv_msg_.msg_controllen = CMSG_SPACE(sizeof(uint32_t));
+}
+
+IoUringBackend::~IoUringBackend() {
+  if (buffer_ring_ != MAP_FAILED) {
+    munmap(buffer_ring_, buffer_ring_size_);
+  }
+}
+
+util::Status IoUringBackend::init() {
+  auto status = send_ring_.init(ring_entries);
+  if (!status.ok()) {
+    return status;
+  }
+  status = recv_ring_.init(ring_entries);
+  if (!status.ok()) {
+    return status;
+  }
+  status = send_ring_.registerFile(sockDesc_);
+  if (!status.ok()) {
+    return status;
+  }
+  status = recv_ring_.registerFile(sockDesc_);
+  if (!status.ok()) {
+    return status;
+  }
+  // The buffer ring has to be page aligned.
+  buffer_ring_ = static_cast<io_uring_buf_ring*>(
+      mmap(nullptr, buffer_ring_size_, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (buffer_ring_ == MAP_FAILED) {
+    return util::Status(util::StatusCode::kUnavailable,
+                        "Buffer ring allocation failed (mmap())");
+  }
+  status =
+      recv_ring_.registerBufferRing(buffer_ring_, buffer_count, buffer_group);
+  if (!status.ok()) {
+    return status;
+  }
+  for (unsigned id = 0; id < buffer_count; id++) {
+    recycleBuffer(id);
+  }
+  status = armReceive();
+  if (!status.ok()) {
+    return status;
+  }
+  // Kernels without multishot receive reject the request right away.
+  const io_uring_cqe* cqe = recv_ring_.peekCqe();
+  if (cqe != nullptr && cqe->res == -EINVAL) {
+    return util::Status(util::StatusCode::kUnimplemented,
+                        "Multishot recvmsg is not supported.");
+  }
+  return util::Status();
+}
+
+util::Status IoUringBackend::armReceive() {
+  io_uring_sqe* sqe = recv_ring_.getSqe();
+  if (sqe == nullptr) {
+    return util::Status(util::StatusCode::kResourceExhausted,
+                        "Submission queue is full.");
+  }
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = 0;
+  sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->addr = reinterpret_cast<uint64_t>(&recv_msg_);
+  sqe->len = 1;
+  sqe->buf_group = buffer_group;
+  const auto int_or = recv_ring_.submitAndWait(0);
+  if (!int_or.ok()) {
+    return int_or.status();
+  }
+  is_receive_armed_ = true;
+  return util::Status();
+}
+
+void IoUringBackend::recycleBuffer(int id) {
+  // The entries are indexed by hand since C++ lays out the flexible `bufs`
+  // member after a padded empty struct, i.e. not at the start of the ring.
+  io_uring_buf* buffer = reinterpret_cast<io_uring_buf*>(buffer_ring_) +
+                         (buffer_tail_ & (buffer_count - 1));
+  buffer->addr = reinterpret_cast<uint64_t>(&buffers_[id * buffer_size]);
+  buffer->len = buffer_size;
+  buffer->bid = id;
+  buffer_tail_ += 1;
+  __atomic_store_n(&buffer_ring_->tail, buffer_tail_, __ATOMIC_RELEASE);
+}
+
+util::StatusOr<int> IoUringBackend::sendBatch(mmsghdr* headers, int count) {
+  int queued = 0;
+  while (queued < count) {
+    io_uring_sqe* sqe = send_ring_.getSqe();
+    if (sqe == nullptr) {
+      break;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = 0;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->addr = reinterpret_cast<uint64_t>(&headers[queued].msg_hdr);
+    sqe->len = 1;
+    sqe->user_data = queued;
+    queued += 1;
+  }
+  if (queued == 0) {
+    return util::Status(util::StatusCode::kResourceExhausted,
+                        "Submission queue is full.");
+  }
+  const auto int_or = send_ring_.submitAndWait(queued);
+  // The kernel takes the entries in order and might stop short, in which case
+  // the rest must not be left behind pointing at the caller's datagrams.
+  const int submitted = queued - send_ring_.withdrawUnsubmitted();
+  if (submitted == 0) {
+    return int_or.ok() ? util::Status(util::StatusCode::kUnknown,
+                                      "Send failed (io_uring_enter())")
+                       : int_or.status();
+  }
+  // The datagrams must not go away before they are sent and hence, wait for
+  // every submitted one even if the submission failed midway. The completions
+  // might come out of order. Report how many datagrams were sent before the
+  // first failure, like sendmmsg does.
+  int sent = submitted;
+  int completed = 0;
+  while (completed < submitted) {
+    const io_uring_cqe* cqe = send_ring_.peekCqe();
+    if (cqe == nullptr) {
+      // The wait might have been cut short by a signal or have failed, but
+      // returning before the sends complete would let the kernel read freed
+      // datagrams, so wait again.
+      send_ring_.submitAndWait(1);
+      continue;
+    }
+    const int index = cqe->user_data;
+    headers[index].msg_len = std::max(cqe->res, 0);
+    if (cqe->res < 0) {
+      sent = std::min(sent, index);
+    }
+    send_ring_.advanceCq();
+    completed += 1;
+  }
+  if (sent == 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Send failed (IORING_OP_SENDMSG)");
+  }
+  return sent;
+}
+
+util::StatusOr<int> IoUringBackend::recvBatch(DatagramBatch& batch,
+                                              bool wait) {
+  batch.reset();
+  int received = 0;
+  while (true) {
+    io_uring_cqe* cqe;
+    while (received < batch.capacity() &&
+           (cqe = recv_ring_.peekCqe()) != nullptr) {
+      if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        // The kernel stopped receiving, most likely because it ran out of
+        // buffers.
+        is_receive_armed_ = false;
+      }
+      if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+        recv_ring_.advanceCq();
+        continue;
+      }
+      const int id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+      if (cqe->res < 0) {
+        recycleBuffer(id);
+        recv_ring_.advanceCq();
+        continue;
+      }
+      const char* buffer = &buffers_[id * buffer_size];
+      const auto out = reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+      const char* name = buffer + sizeof(io_uring_recvmsg_out);
+      const char* payload =
+          name + recv_msg_.msg_namelen + recv_msg_.msg_controllen;
+      const int length = std::max<int>(
+          std::min<int>(
+              std::min<int>(out->payloadlen, cqe->res - (payload - buffer)),
+              batch.bufferLen_),
+          0);
+      memcpy(batch.iovecs_[received].iov_base, payload, length);
+      if (out->namelen >= sizeof(sockaddr_in)) {
+        memcpy(&batch.addrs_[received], name, sizeof(sockaddr_in));
+      }
+      if (out->controllen > 0) {
+        msghdr msg = {};
+        msg.msg_control = const_cast<char*>(name + recv_msg_.msg_namelen);
+        msg.msg_controllen = out->controllen;
+        batch.recordDropCount(msg);
+      }
+      batch.headers_[received].msg_len = length;
+      received += 1;
+      recycleBuffer(id);
+      recv_ring_.advanceCq();
+    }
+    if (!is_receive_armed_) {
+      const auto status = armReceive();
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    if (received > 0 || !wait) {
+      break;
+    }
+    const auto int_or = recv_ring_.submitAndWait(1);
+    if (!int_or.ok()) {
+      return int_or.status();
+    }
+  }
+  batch.size_ = received;
+  return received;
+}
+
+}  // namespace socket
+}  // namespace da
@@ -0,0 +1,134 @@
+#ifndef __INCLUDED_DA_SOCKET_IO_URING_H_
+#define __INCLUDED_DA_SOCKET_IO_URING_H_
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <cstddef>
+#include <vector>
+
+#include <da/util/status.h>
+#include <da/util/statusor.h>
+
+namespace da {
+namespace socket {
+
+class DatagramBatch;
+
+// A minimal io_uring instance set up with the raw system calls. The ring is
+// not thread-safe and must be driven by one thread at a time.
+class IoUring {
+ public:
+  IoUring();
+
+  ~IoUring();
+
+  // Delete the copy constructor.
+  IoUring(const IoUring&) = delete;
+  // Delete the copy assignment operator.
+  IoUring& operator=(const IoUring&) = delete;
+
+  // Sets up the ring with room for `entries` submissions.
+  util::Status init(unsigned entries);
+
+  int getDescriptor() const { return fd_; }
+
+  unsigned getEntries() const { return sq_entries_; }
+
+  // Registers the descriptor as the fixed file with index 0.
+  util::Status registerFile(int fd);
+
+  // Registers a ring of buffers the kernel picks from for the requests of the
+  // given buffer group.
+  util::Status registerBufferRing(io_uring_buf_ring* ring, unsigned entries,
+                                  int group);
+
+  // Returns a cleared submission entry or nullptr if the queue is full.
+  io_uring_sqe* getSqe();
+
+  // Submits the queued entries and waits for at least `min_complete`
+  // completions. Returns the number of entries submitted.
+  util::StatusOr<int> submitAndWait(unsigned min_complete);
+
+  // Withdraws the queued entries the kernel has not taken yet so that they are
+  // not submitted later. Returns the number of entries withdrawn.
+  int withdrawUnsubmitted();
+
+  // Returns the next completion or nullptr if there is none.
+  io_uring_cqe* peekCqe();
+
+  // Consumes the completion returned by `peekCqe`.
+  void advanceCq();
+
+ private:
+  int fd_;
+  void* sq_ring_;
+  std::size_t sq_ring_size_;
+  void* cq_ring_;
+  std::size_t cq_ring_size_;
+  io_uring_sqe* sqes_;
+  std::size_t sqes_size_;
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned* sq_array_;
+  unsigned sq_mask_;
+  unsigned sq_entries_;
+  // Denotes the tail including the entries that have not been submitted yet.
+  unsigned sqe_tail_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqes_;
+};
+
+// Sends and receives the datagrams of a socket through io_uring. Sends are
+// submitted as a batch of `sendmsg` requests with a single system call. A
+// single multishot `recvmsg` keeps receiving into a ring of buffers registered
+// with the kernel and hence, receiving does not need a system call as long as
+// completions are pending.
+//
+// Sending and receiving use separate rings so that they can be driven from
+// different threads.
+class IoUringBackend {
+ public:
+  IoUringBackend(int sockDesc);
+
+  ~IoUringBackend();
+
+  // Delete the copy constructor.
+  IoUringBackend(const IoUringBackend&) = delete;
+  // Delete the copy assignment operator.
+  IoUringBackend& operator=(const IoUringBackend&) = delete;
+
+  // Fails if the kernel lacks the support for any of the features used.
+  util::Status init();
+
+  // Becomes readable whenever received datagrams are pending.
+  int getPollDescriptor() const { return recv_ring_.getDescriptor(); }
+
+  util::StatusOr<int> sendBatch(mmsghdr* headers, int count);
+
+  util::StatusOr<int> recvBatch(DatagramBatch& batch, bool wait);
+
+ private:
+  // (Re)submits the multishot receive.
+  util::Status armReceive();
+
+  // Hands the buffer back to the kernel.
+  void recycleBuffer(int id);
+
+  const int sockDesc_;
+  IoUring send_ring_;
+  IoUring recv_ring_;
+  io_uring_buf_ring* buffer_ring_;
+  std::size_t buffer_ring_size_;
+  std::vector<char> buffers_;
+  unsigned short buffer_tail_;
+  // Describes the layout of the received buffers.
+  msghdr recv_msg_;
+  bool is_receive_armed_;
+};
+
+}  // namespace socket
+}  // namespace da
+
+#endif  // __INCLUDED_DA_SOCKET_IO_URING_H_
@@ -8,11 +8,14 @@ util::Status fillAddr(const std::string &address, unsigned short port,
   memset(&addr, 0, sizeof(addr));
   addr.sin_family = AF_INET;
   addr.sin_port = htons(port);
-  inet_pton(AF_INET, address.c_str(), &addr.sin_addr);
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    return util::Status(util::StatusCode::kInvalidArgument,
+                        address + " is not a valid IPv4 address.");
+  }
   return util::Status();
 }
 
-Socket::Socket(int type, int port) throw() {
+Socket::Socket(int type, int port) {
   if ((sockDesc_ = ::socket(PF_INET, type, port)) < 0) {
     throw util::RuntimeStatusError(util::Status(
         util::StatusCode::kUnknown, "Socket creation failed (socket())"));
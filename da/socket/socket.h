@@ -28,6 +28,9 @@ class Socket {
   // Closes and deallocates the socket.
   ~Socket();
 
+  // Returns the socket descriptor so that the socket can be polled.
+  int getDescriptor() const { return sockDesc_; }
+
   util::StatusOr<std::string> getLocalAddress();
 
   util::StatusOr<unsigned short> getLocalPort();
@@ -47,7 +50,7 @@ class Socket {
                                        const std::string& protocol = "udp");
 
  protected:
-  Socket(int type, int protocol) throw();
+  Socket(int type, int protocol);
   Socket(int sockDesc);
   // The socket descriptor.
   int sockDesc_;
@@ -1,32 +1,134 @@
 #include <da/socket/udp_socket.h>
 
 #include <errno.h>
+#include <linux/filter.h>
+#include <cstdint>
+#include <utility>
 
 #include <da/socket/communicating_socket.h>
+#include <da/socket/io_uring.h>
 
 namespace da {
 namespace socket {
+namespace {
 
-UDPSocket::UDPSocket() throw() : CommunicatingSocket(SOCK_DGRAM, IPPROTO_UDP) {
+// Denotes the room for the control message carrying the drop count.
+const int control_len = CMSG_SPACE(sizeof(uint32_t));
+
+}  // namespace
+
+DatagramBatch::DatagramBatch(int capacity, int bufferLen)
+    : bufferLen_(bufferLen),
+      size_(0),
+      pool_(nullptr),
+      buffers_(capacity * bufferLen),
+      controls_(capacity * control_len),
+      addrs_(capacity),
+      iovecs_(capacity),
+      headers_(capacity),
+      has_drop_count_(false),
+      drop_count_(0) {
+  memset(headers_.data(), 0, capacity * sizeof(mmsghdr));
+  for (int i = 0; i < capacity; i++) {
+    iovecs_[i].iov_base = &buffers_[i * bufferLen_];
+    iovecs_[i].iov_len = bufferLen_;
+    headers_[i].msg_hdr.msg_name = &addrs_[i];
+    headers_[i].msg_hdr.msg_namelen = sizeof(addrs_[i]);
+    headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+    headers_[i].msg_hdr.msg_iovlen = 1;
+    headers_[i].msg_hdr.msg_control = &controls_[i * control_len];
+    headers_[i].msg_hdr.msg_controllen = control_len;
+  }
+}
+
+DatagramBatch::DatagramBatch(int capacity, util::BufferPool* pool)
+    : bufferLen_(pool->getBufferSize()),
+      size_(0),
+      pool_(pool),
+      pooled_buffers_(capacity),
+      controls_(capacity * control_len),
+      addrs_(capacity),
+      iovecs_(capacity),
+      headers_(capacity),
+      has_drop_count_(false),
+      drop_count_(0) {
+  memset(headers_.data(), 0, capacity * sizeof(mmsghdr));
+  for (int i = 0; i < capacity; i++) {
+    pooled_buffers_[i] = pool_->acquire();
+    iovecs_[i].iov_base = pooled_buffers_[i].data();
+    iovecs_[i].iov_len = bufferLen_;
+    headers_[i].msg_hdr.msg_name = &addrs_[i];
+    headers_[i].msg_hdr.msg_namelen = sizeof(addrs_[i]);
+    headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+    headers_[i].msg_hdr.msg_iovlen = 1;
+    headers_[i].msg_hdr.msg_control = &controls_[i * control_len];
+    headers_[i].msg_hdr.msg_controllen = control_len;
+  }
+}
+
+util::PooledBuffer DatagramBatch::takeBuffer(int i) {
+  util::PooledBuffer buffer = std::move(pooled_buffers_[i]);
+  pooled_buffers_[i] = pool_->acquire();
+  iovecs_[i].iov_base = pooled_buffers_[i].data();
+  return buffer;
+}
+
+void DatagramBatch::reset() {
+  // The kernel only overwrites the headers of the datagrams it received.
+  for (int i = 0; i < size_; i++) {
+    headers_[i].msg_hdr.msg_namelen = sizeof(addrs_[i]);
+    headers_[i].msg_hdr.msg_controllen = control_len;
+    headers_[i].msg_hdr.msg_flags = 0;
+    headers_[i].msg_len = 0;
+  }
+  size_ = 0;
+  has_drop_count_ = false;
+}
+
+void DatagramBatch::recordDropCount(const msghdr &msg) {
+  for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<msghdr *>(&msg), cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+      memcpy(&drop_count_, CMSG_DATA(cmsg), sizeof(drop_count_));
+      has_drop_count_ = true;
+    }
+  }
+}
+
+UDPSocket::UDPSocket()
+    : CommunicatingSocket(SOCK_DGRAM, IPPROTO_UDP), drop_count_(0) {
   setBroadcast();
 }
 
-UDPSocket::UDPSocket(unsigned short localPort) throw()
-    : CommunicatingSocket(SOCK_DGRAM, IPPROTO_UDP) {
+UDPSocket::UDPSocket(unsigned short localPort)
+    : CommunicatingSocket(SOCK_DGRAM, IPPROTO_UDP), drop_count_(0) {
   setLocalPort(localPort);
   setBroadcast();
 }
 
 UDPSocket::UDPSocket(const std::string &localAddress,
-                     unsigned short localPort) throw()
-    : CommunicatingSocket(SOCK_DGRAM, IPPROTO_UDP) {
+                     unsigned short localPort)
+    : CommunicatingSocket(SOCK_DGRAM, IPPROTO_UDP), drop_count_(0) {
   setLocalAddressAndPort(localAddress, localPort);
   setBroadcast();
 }
 
 UDPSocket::UDPSocket(const std::string &localAddress, unsigned short localPort,
-                     struct timeval tv) throw()
-    : CommunicatingSocket(SOCK_DGRAM, IPPROTO_UDP) {
+                     struct timeval tv)
+    : UDPSocket(localAddress, localPort, tv, false) {}
+
+UDPSocket::UDPSocket(const std::string &localAddress, unsigned short localPort,
+                     struct timeval tv, bool reusePort)
+    : CommunicatingSocket(SOCK_DGRAM, IPPROTO_UDP), drop_count_(0) {
+  int reusePortPermission = 1;
+  if (reusePort &&
+      setsockopt(sockDesc_, SOL_SOCKET, SO_REUSEPORT,
+                 (void *)&reusePortPermission,
+                 sizeof(reusePortPermission)) < 0) {
+    throw util::RuntimeStatusError(
+        util::Status(util::StatusCode::kUnknown,
+                     "Set of port reuse failed (setsockopt())"));
+  }
   const auto status = setLocalAddressAndPort(localAddress, localPort);
   if (!status.ok()) {
     throw util::RuntimeStatusError(status);
@@ -35,6 +137,100 @@ UDPSocket::UDPSocket(const std::string &localAddress, unsigned short localPort,
   setTimeout(tv);
 }
 
+UDPSocket::~UDPSocket() {}
+
+util::Status UDPSocket::steerReusePortGroup(int groupSize, int offset) {
+  if (groupSize <= 0 || offset < 0) {
+    return util::Status(util::StatusCode::kInvalidArgument,
+                        "Group size must be positive and offset non-negative");
+  }
+  // The program runs on the UDP payload. A datagram too short to carry the
+  // key aborts the program, which returns the first socket.
+  sock_filter code[] = {
+      {BPF_LD | BPF_H | BPF_ABS, 0, 0, static_cast<uint32_t>(offset)},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(groupSize)},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  sock_fprog program;
+  program.len = sizeof(code) / sizeof(code[0]);
+  program.filter = code;
+  if (setsockopt(sockDesc_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                 (void *)&program, sizeof(program)) < 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Steering of port reuse group failed (setsockopt())");
+  }
+  return util::Status();
+}
+
+util::Status UDPSocket::enableIoUring() {
+  auto uring = std::make_unique<IoUringBackend>(sockDesc_);
+  const auto status = uring->init();
+  if (!status.ok()) {
+    return status;
+  }
+  uring_ = std::move(uring);
+  return util::Status();
+}
+
+int UDPSocket::getPollDescriptor() const {
+  if (uring_ != nullptr) {
+    return uring_->getPollDescriptor();
+  }
+  return sockDesc_;
+}
+
+util::Status UDPSocket::setReceiveBufferSize(int size) {
+  return setBufferSize(SO_RCVBUF, SO_RCVBUFFORCE, size);
+}
+
+util::Status UDPSocket::setSendBufferSize(int size) {
+  return setBufferSize(SO_SNDBUF, SO_SNDBUFFORCE, size);
+}
+
+util::StatusOr<int> UDPSocket::getReceiveBufferSize() const {
+  return getBufferSize(SO_RCVBUF);
+}
+
+util::StatusOr<int> UDPSocket::getSendBufferSize() const {
+  return getBufferSize(SO_SNDBUF);
+}
+
+util::Status UDPSocket::setBufferSize(int option, int forceOption, int size) {
+  // Try to go beyond the system-wide limit first which needs CAP_NET_ADMIN.
+  if (setsockopt(sockDesc_, SOL_SOCKET, forceOption, (void *)&size,
+                 sizeof(size)) == 0) {
+    return util::Status();
+  }
+  if (setsockopt(sockDesc_, SOL_SOCKET, option, (void *)&size, sizeof(size)) <
+      0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Buffer size set failed (setsockopt())");
+  }
+  return util::Status();
+}
+
+util::StatusOr<int> UDPSocket::getBufferSize(int option) const {
+  int size;
+  socklen_t size_len = sizeof(size);
+  if (getsockopt(sockDesc_, SOL_SOCKET, option, (void *)&size, &size_len) <
+      0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Buffer size fetch failed (getsockopt())");
+  }
+  return size;
+}
+
+util::Status UDPSocket::enableDropCounting() {
+  int dropCountPermission = 1;
+  if (setsockopt(sockDesc_, SOL_SOCKET, SO_RXQ_OVFL,
+                 (void *)&dropCountPermission,
+                 sizeof(dropCountPermission)) < 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Drop counting set failed (setsockopt())");
+  }
+  return util::Status();
+}
+
 void UDPSocket::setTimeout(struct timeval tv) {
   setsockopt(sockDesc_, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof(tv));
 }
@@ -69,14 +265,32 @@ util::Status UDPSocket::sendTo(const void *buffer, int bufferLen,
   if (!status.ok()) {
     return status;
   }
+  return sendTo(buffer, bufferLen, destAddr);
+}
+
+util::Status UDPSocket::sendTo(const void *buffer, int bufferLen,
+                               const sockaddr_in &foreignAddr) {
   // Write out the whole buffer as a single message.
-  if (::sendto(sockDesc_, (void *)buffer, bufferLen, 0, (sockaddr *)&destAddr,
-               sizeof(destAddr)) != bufferLen) {
+  if (::sendto(sockDesc_, (void *)buffer, bufferLen, 0,
+               (const sockaddr *)&foreignAddr,
+               sizeof(foreignAddr)) != bufferLen) {
     return util::Status(util::StatusCode::kUnknown, "Send failed (sendto())");
   }
   return util::Status();
 }
 
+util::StatusOr<int> UDPSocket::sendBatch(mmsghdr *headers, int count) {
+  if (uring_ != nullptr) {
+    return uring_->sendBatch(headers, count);
+  }
+  int rtn;
+  if ((rtn = ::sendmmsg(sockDesc_, headers, count, 0)) < 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Send failed (sendmmsg())");
+  }
+  return rtn;
+}
+
 util::StatusOr<int> UDPSocket::recvFrom(void *buffer, int bufferLen,
                                         std::string &sourceAddress,
                                         unsigned short &sourcePort) {
@@ -93,6 +307,34 @@ util::StatusOr<int> UDPSocket::recvFrom(void *buffer, int bufferLen,
   return rtn;
 }
 
+util::StatusOr<int> UDPSocket::recvBatch(DatagramBatch &batch, bool wait) {
+  if (uring_ != nullptr) {
+    const auto int_or = uring_->recvBatch(batch, wait);
+    if (batch.has_drop_count_) {
+      drop_count_ = batch.drop_count_;
+    }
+    return int_or;
+  }
+  batch.reset();
+  // Wait for the first datagram only and take whatever else is queued.
+  const int flags = wait ? MSG_WAITFORONE : MSG_DONTWAIT;
+  int rtn;
+  if ((rtn = ::recvmmsg(sockDesc_, batch.headers_.data(), batch.capacity(),
+                        flags, nullptr)) < 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Receive failed (recvmmsg())");
+  }
+  batch.size_ = rtn;
+  // The count only grows and hence, the last datagram carries the latest.
+  if (rtn > 0) {
+    batch.recordDropCount(batch.headers_[rtn - 1].msg_hdr);
+    if (batch.has_drop_count_) {
+      drop_count_ = batch.drop_count_;
+    }
+  }
+  return rtn;
+}
+
 util::Status UDPSocket::setMulticastTTL(unsigned char multicastTTL) {
   if (setsockopt(sockDesc_, IPPROTO_IP, IP_MULTICAST_TTL, (void *)&multicastTTL,
                  sizeof(multicastTTL)) < 0) {
@@ -114,6 +356,31 @@ util::Status UDPSocket::joinGroup(const std::string &multicastGroup) {
   return util::Status();
 }
 
+util::Status UDPSocket::joinGroup(const std::string &multicastGroup,
+                                  const std::string &interfaceAddress) {
+  struct ip_mreq multicastRequest;
+  multicastRequest.imr_multiaddr.s_addr = inet_addr(multicastGroup.c_str());
+  multicastRequest.imr_interface.s_addr = inet_addr(interfaceAddress.c_str());
+  if (setsockopt(sockDesc_, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                 (void *)&multicastRequest, sizeof(multicastRequest)) < 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Multicast group join failed (setsockopt())");
+  }
+  return util::Status();
+}
+
+util::Status UDPSocket::setMulticastInterface(
+    const std::string &interfaceAddress) {
+  struct in_addr interfaceAddr;
+  interfaceAddr.s_addr = inet_addr(interfaceAddress.c_str());
+  if (setsockopt(sockDesc_, IPPROTO_IP, IP_MULTICAST_IF, (void *)&interfaceAddr,
+                 sizeof(interfaceAddr)) < 0) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Multicast interface set failed (setsockopt())");
+  }
+  return util::Status();
+}
+
 util::Status UDPSocket::leaveGroup(const std::string &multicastGroup) {
   struct ip_mreq multicastRequest;
   multicastRequest.imr_multiaddr.s_addr = inet_addr(multicastGroup.c_str());
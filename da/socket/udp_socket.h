@@ -1,23 +1,133 @@
 #ifndef __INCLUDED_DA_SOCKET_UDP_SOCKET_H_
 #define __INCLUDED_DA_SOCKET_UDP_SOCKET_H_
 
+#include <sys/socket.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <da/socket/communicating_socket.h>
+#include <da/util/buffer_pool.h>
 
 namespace da {
 namespace socket {
 
+class IoUringBackend;
+
+// A reusable set of buffers that receives a batch of datagrams along with
+// their source addresses in a single system call.
+class DatagramBatch {
+ public:
+  DatagramBatch(int capacity, int bufferLen);
+
+  // Receives straight into the buffers of the pool so that a datagram can be
+  // taken out of the batch without copying it.
+  DatagramBatch(int capacity, util::BufferPool* pool);
+
+  // Delete the copy constructor.
+  DatagramBatch(const DatagramBatch&) = delete;
+  // Delete the copy assignment operator.
+  DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+  int capacity() const { return headers_.size(); }
+
+  // Denotes the number of datagrams received by the last receive.
+  int size() const { return size_; }
+
+  const char* getData(int i) const {
+    return static_cast<const char*>(iovecs_[i].iov_base);
+  }
+
+  int getLength(int i) const { return headers_[i].msg_len; }
+
+  const sockaddr_in& getSourceAddr(int i) const { return addrs_[i]; }
+
+  // Hands over the pooled buffer holding the i-th datagram and puts a fresh
+  // one in its place. Must only be called on batches backed by a pool.
+  util::PooledBuffer takeBuffer(int i);
+
+ private:
+  friend class IoUringBackend;
+  friend class UDPSocket;
+
+  // Prepares the headers for the next receive.
+  void reset();
+
+  // Records the drop count carried by the control messages, if any.
+  void recordDropCount(const msghdr& msg);
+
+  const int bufferLen_;
+  int size_;
+  util::BufferPool* pool_;
+  // Holds the datagrams unless the batch is backed by a pool.
+  std::vector<char> buffers_;
+  std::vector<util::PooledBuffer> pooled_buffers_;
+  std::vector<char> controls_;
+  std::vector<sockaddr_in> addrs_;
+  std::vector<iovec> iovecs_;
+  std::vector<mmsghdr> headers_;
+  // Denotes the latest drop count reported by the last receive.
+  bool has_drop_count_;
+  uint32_t drop_count_;
+};
+
 class UDPSocket : public CommunicatingSocket {
  public:
-  UDPSocket() throw();
+  UDPSocket();
 
-  UDPSocket(unsigned short localPort) throw();
+  UDPSocket(unsigned short localPort);
 
-  UDPSocket(const std::string& localAddress, unsigned short localPort) throw();
+  UDPSocket(const std::string& localAddress, unsigned short localPort);
 
   UDPSocket(const std::string& localAddress, unsigned short localPort,
-            struct timeval tv) throw();
+            struct timeval tv);
+
+  // Sets SO_REUSEPORT before binding if `reusePort` is set so that a group of
+  // sockets can share the address. The kernel then spreads the incoming
+  // datagrams across the group. Throws `util::RuntimeStatusError` if the
+  // socket cannot be set up or bound.
+  UDPSocket(const std::string& localAddress, unsigned short localPort,
+            struct timeval tv, bool reusePort);
+
+  ~UDPSocket();
+
+  // Steers every incoming datagram of the SO_REUSEPORT group to the socket
+  // whose index is the 16-bit big-endian integer at `offset` in the payload
+  // modulo `groupSize`. Sockets are indexed in the order they were bound in.
+  // Attaching to any socket of the group applies to the whole group.
+  util::Status steerReusePortGroup(int groupSize, int offset);
+
+  // Moves the batched send and receive paths over to io_uring. The socket
+  // keeps using the system calls if this fails, e.g. if the kernel lacks the
+  // support for it.
+  util::Status enableIoUring();
+
+  bool isIoUringEnabled() const { return uring_ != nullptr; }
+
+  // Returns the descriptor that becomes readable when `recvBatch` has
+  // datagrams to return.
+  int getPollDescriptor() const;
+
+  // Sizes the kernel buffers of the socket. Beyond the system-wide limits the
+  // size is only honored for privileged processes.
+  util::Status setReceiveBufferSize(int size);
+
+  util::Status setSendBufferSize(int size);
+
+  // Returns the sizes actually in effect which the kernel doubles to account
+  // for its bookkeeping.
+  util::StatusOr<int> getReceiveBufferSize() const;
+
+  util::StatusOr<int> getSendBufferSize() const;
+
+  // Has the kernel report along the received datagrams how many datagrams it
+  // dropped because the receive buffer was full (SO_RXQ_OVFL).
+  util::Status enableDropCounting();
+
+  // Returns the number of datagrams dropped as of the latest receive.
+  uint32_t getDropCount() const { return drop_count_; }
 
   // Unset foreign address and port.
   util::Status disconnect();
@@ -27,24 +137,54 @@ class UDPSocket : public CommunicatingSocket {
                       const std::string& foreignAddress,
                       unsigned short foreignPort);
 
+  // Send the given buffer as a UDP datagram to the resolved address.
+  util::Status sendTo(const void* buffer, int bufferLen,
+                      const sockaddr_in& foreignAddr);
+
+  // Send the given datagrams with a single system call. Every header must
+  // carry its destination address unless the socket is connected. Returns the
+  // number of datagrams sent which might be less than `count`.
+  util::StatusOr<int> sendBatch(mmsghdr* headers, int count);
+
   // Read read up to bufferLen bytes data from this socket.  The given buffer is
   // where the data will be placed.
   util::StatusOr<int> recvFrom(void* buffer, int bufferLen,
                                std::string& sourceAddress,
                                unsigned short& sourcePort);
 
+  // Receives up to `batch.capacity()` datagrams with a single system call.
+  // Blocks until at least one datagram is available (or the receive timeout
+  // expires) unless `wait` is unset and returns the number of datagrams
+  // received.
+  util::StatusOr<int> recvBatch(DatagramBatch& batch, bool wait = true);
+
   // Set the multicast TTL.
   util::Status setMulticastTTL(unsigned char multicastTTL);
 
   // Join the specified multicast group.
   util::Status joinGroup(const std::string& multicastGroup);
 
+  // Join the specified multicast group on the interface with the given
+  // address.
+  util::Status joinGroup(const std::string& multicastGroup,
+                         const std::string& interfaceAddress);
+
+  // Send the multicast datagrams through the interface with the given address.
+  util::Status setMulticastInterface(const std::string& interfaceAddress);
+
   // Leave the specified multicast group.
   util::Status leaveGroup(const std::string& multicastGroup);
 
  private:
   void setBroadcast();
   void setTimeout(struct timeval tv);
+
+  util::Status setBufferSize(int option, int forceOption, int size);
+
+  util::StatusOr<int> getBufferSize(int option) const;
+
+  std::unique_ptr<IoUringBackend> uring_;
+  std::atomic<uint32_t> drop_count_;
 };
 
 }  // namespace socket
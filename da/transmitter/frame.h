@@ -0,0 +1,54 @@
+#ifndef __INCLUDED_DA_TRANSMITTER_FRAME_H_
+#define __INCLUDED_DA_TRANSMITTER_FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <da/util/wire.h>
+
+namespace da {
+namespace transmitter {
+
+// A frame is the payload of a single datagram and packs one or more messages
+// to the same peer. Every message is preceded by its length as a 16-bit
+// integer.
+const int frame_header_size = sizeof(uint16_t);
+
+// Denotes the largest message a frame can hold.
+const int max_message_length = UINT16_MAX;
+
+// Appends the message to the frame.
+inline void appendToFrame(std::string& frame, const char* msg, int length) {
+  const std::size_t offset = frame.size();
+  frame.resize(offset + frame_header_size + length);
+  util::storeBigEndian<uint16_t>(&frame[offset], length);
+  memcpy(&frame[offset + frame_header_size], msg, length);
+}
+
+// Calls `on_message` with the offset and the length of every message packed in
+// the frame of `length` bytes. Returns false if the frame is malformed, in
+// which case only the messages preceding the malformed part are visited.
+template <typename OnMessage>
+bool forEachMessage(const char* frame, int length, OnMessage on_message) {
+  int offset = 0;
+  while (offset < length) {
+    if (length - offset < frame_header_size) {
+      return false;
+    }
+    const int msg_length = util::loadBigEndian<uint16_t>(frame + offset);
+    offset += frame_header_size;
+    if (msg_length > length - offset) {
+      return false;
+    }
+    on_message(offset, msg_length);
+    offset += msg_length;
+  }
+  return true;
+}
+
+}  // namespace transmitter
+}  // namespace da
+
+#endif  // __INCLUDED_DA_TRANSMITTER_FRAME_H_
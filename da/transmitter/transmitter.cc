@@ -0,0 +1,255 @@
+#include <da/transmitter/transmitter.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include <da/transmitter/frame.h>
+#include <da/util/logging.h>
+#include <da/util/util.h>
+
+namespace da {
+namespace transmitter {
+namespace {
+
+const int default_batch_size = 64;
+const std::chrono::microseconds default_max_delay(100);
+// Denotes the maximum number of datagrams the kernel accepts in a single call.
+const int max_batch_size = 1024;
+// Fills an Ethernet MTU after the IP and UDP headers.
+const int default_max_frame_size = 1472;
+
+}  // namespace
+
+Transmitter::Transmitter(socket::UDPSocket* sock)
+    : Transmitter(sock, default_max_frame_size) {}
+
+Transmitter::Transmitter(socket::UDPSocket* sock, int max_frame_size)
+    : Transmitter(sock, false, max_frame_size) {}
+
+Transmitter::Transmitter(socket::UDPSocket* sock, bool connect_peers,
+                         int max_frame_size)
+    : Transmitter(sock, default_batch_size, default_max_delay, connect_peers,
+                  max_frame_size) {}
+
+Transmitter::Transmitter(socket::UDPSocket* sock, int batch_size,
+                         std::chrono::microseconds max_delay)
+    : Transmitter(sock, batch_size, max_delay, false) {}
+
+Transmitter::Transmitter(socket::UDPSocket* sock, int batch_size,
+                         std::chrono::microseconds max_delay,
+                         bool connect_peers)
+    : Transmitter(sock, batch_size, max_delay, connect_peers,
+                  default_max_frame_size) {}
+
+Transmitter::Transmitter(socket::UDPSocket* sock, int batch_size,
+                         std::chrono::microseconds max_delay,
+                         bool connect_peers, int max_frame_size)
+    : alive_(true),
+      sock_(sock),
+      batch_size_(std::min(std::max(batch_size, 1), max_batch_size)),
+      max_delay_(max_delay),
+      connect_peers_(connect_peers),
+      max_frame_size_(max_frame_size),
+      idle_(false) {
+  queue_.reserve(batch_size_);
+}
+
+void Transmitter::stop() {
+  alive_ = false;
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_var_.notify_all();
+}
+
+util::Status Transmitter::sendTo(const void* buffer, int bufferLen,
+                                 const std::string& foreignAddress,
+                                 unsigned short foreignPort) {
+  sockaddr_in foreignAddr;
+  const auto status =
+      socket::fillAddr(foreignAddress, foreignPort, foreignAddr);
+  if (!status.ok()) {
+    return status;
+  }
+  return sendTo(buffer, bufferLen, foreignAddr);
+}
+
+util::Status Transmitter::sendTo(const void* buffer, int bufferLen,
+                                 const sockaddr_in& foreignAddr) {
+  if (!isAlive()) {
+    return util::Status(util::StatusCode::kUnknown,
+                        "Transmitter has been stopped.");
+  }
+  if (bufferLen > max_message_length) {
+    return util::Status(util::StatusCode::kInvalidArgument,
+                        "Buffer does not fit in a frame.");
+  }
+  const char* data = static_cast<const char*>(buffer);
+  const uint64_t key = toPeerKey(foreignAddr);
+  std::vector<Datagram> datagrams;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto it = open_frames_.find(key);
+    if (it != open_frames_.end() &&
+        int(queue_[it->second].data.size()) + frame_header_size + bufferLen <=
+            max_frame_size_) {
+      appendToFrame(queue_[it->second].data, data, bufferLen);
+      return util::Status();
+    }
+    // Start a new frame for the peer. A buffer larger than a frame gets one
+    // of its own.
+    if (queue_.empty()) {
+      oldest_ = std::chrono::steady_clock::now();
+      // The flusher only needs to hear about the datagram that starts the
+      // deadline.
+      if (idle_) {
+        cond_var_.notify_one();
+      }
+    }
+    queue_.emplace_back();
+    Datagram& datagram = queue_.back();
+    datagram.addr = foreignAddr;
+    datagram.data.reserve(max_frame_size_);
+    appendToFrame(datagram.data, data, bufferLen);
+    open_frames_[key] = queue_.size() - 1;
+    if (int(queue_.size()) < batch_size_) {
+      return util::Status();
+    }
+    // The batch is full. The sender flushes it by itself which keeps the
+    // queue short and slows down senders that outpace the socket.
+    datagrams.swap(queue_);
+    queue_.reserve(batch_size_);
+    open_frames_.clear();
+  }
+  flush(datagrams);
+  return util::Status();
+}
+
+void Transmitter::operator()() {
+  std::vector<Datagram> datagrams;
+  while (isAlive()) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      idle_ = true;
+      cond_var_.wait(lock, [this] { return !isAlive() || !queue_.empty(); });
+      idle_ = false;
+      if (!isAlive()) {
+        break;
+      }
+      // Give the queue a short while to fill up. It might be flushed by a
+      // sender in the meantime.
+      const auto deadline = oldest_ + max_delay_;
+      if (std::chrono::steady_clock::now() < deadline) {
+        cond_var_.wait_until(lock, deadline);
+        continue;
+      }
+      datagrams.swap(queue_);
+      open_frames_.clear();
+    }
+    flush(datagrams);
+    datagrams.clear();
+  }
+}
+
+void Transmitter::addSharedMemoryPeer(const sockaddr_in& addr,
+                                      std::unique_ptr<shm::Outbox> outbox) {
+  std::unique_lock<std::mutex> lock(flush_mutex_);
+  outboxes_[toPeerKey(addr)] = std::move(outbox);
+}
+
+void Transmitter::flush(std::vector<Datagram>& datagrams) {
+  std::unique_lock<std::mutex> lock(flush_mutex_);
+  // Leave out the datagrams that made it into the outboxes.
+  order_.clear();
+  for (int i = 0; i < int(datagrams.size()); i++) {
+    if (!outboxes_.empty()) {
+      const auto it = outboxes_.find(toPeerKey(datagrams[i].addr));
+      if (it != outboxes_.end() &&
+          it->second->push(datagrams[i].data.data(),
+                           datagrams[i].data.size())) {
+        pushed_outboxes_.push_back(it->second.get());
+        continue;
+      }
+    }
+    order_.push_back(i);
+  }
+  for (const auto& outbox : pushed_outboxes_) {
+    outbox->notify();
+  }
+  pushed_outboxes_.clear();
+  const int count = order_.size();
+  sockets_.resize(count);
+  if (connect_peers_) {
+    // Group the datagrams by their peer so that each connected socket sends
+    // its share in a single call. The order of the datagrams to the same peer
+    // is preserved.
+    std::stable_sort(order_.begin(), order_.end(), [&](int lhs, int rhs) {
+      return toPeerKey(datagrams[lhs].addr) < toPeerKey(datagrams[rhs].addr);
+    });
+  }
+  iovecs_.resize(count);
+  headers_.resize(count);
+  memset(headers_.data(), 0, count * sizeof(mmsghdr));
+  for (int i = 0; i < count; i++) {
+    Datagram& datagram = datagrams[order_[i]];
+    sockets_[i] = connect_peers_ ? getPeerSocket(datagram.addr) : nullptr;
+    iovecs_[i].iov_base = &datagram.data[0];
+    iovecs_[i].iov_len = datagram.data.size();
+    // A connected socket already knows where its datagrams go.
+    if (sockets_[i] == nullptr) {
+      headers_[i].msg_hdr.msg_name = &datagram.addr;
+      headers_[i].msg_hdr.msg_namelen = sizeof(datagram.addr);
+    }
+    headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+    headers_[i].msg_hdr.msg_iovlen = 1;
+  }
+  int sent = 0;
+  while (sent < count) {
+    // Send the run of datagrams that go through the same socket.
+    int end = sent + 1;
+    while (end < count && end - sent < max_batch_size &&
+           sockets_[end] == sockets_[sent]) {
+      end += 1;
+    }
+    socket::UDPSocket* sock =
+        sockets_[sent] == nullptr ? sock_ : sockets_[sent];
+    const auto int_or = sock->sendBatch(&headers_[sent], end - sent);
+    if (!int_or.ok()) {
+      // Skip the datagram that could not be sent. It is up to the perfect
+      // links to retransmit it.
+      LOG("Sending of message '",
+          util::stringToBinary(&datagrams[order_[sent]].data),
+          "' failed. Status: ", int_or.status());
+      sent += 1;
+      continue;
+    }
+    sent += int_or.value();
+  }
+}
+
+uint64_t Transmitter::toPeerKey(const sockaddr_in& addr) {
+  return (uint64_t(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+}
+
+socket::UDPSocket* Transmitter::getPeerSocket(const sockaddr_in& addr) {
+  const uint64_t key = toPeerKey(addr);
+  const auto it = peers_.find(key);
+  if (it != peers_.end()) {
+    return it->second.get();
+  }
+  // The socket is bound to an ephemeral port and hence, only ever sends. The
+  // peers reply to the address they know this process by.
+  auto peer = std::make_unique<socket::UDPSocket>();
+  const auto status = peer->connect(addr);
+  if (!status.ok()) {
+    LOG("Unable to connect a socket to peer. Status: ", status);
+    // Fall back to the shared socket for this peer from now on.
+    peer = nullptr;
+  }
+  socket::UDPSocket* sock = peer.get();
+  peers_[key] = std::move(peer);
+  return sock;
+}
+
+}  // namespace transmitter
+}  // namespace da
@@ -0,0 +1,129 @@
+#ifndef __INCLUDED_DA_TRANSMITTER_TRANSMITTER_H_
+#define __INCLUDED_DA_TRANSMITTER_TRANSMITTER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <da/shm/shared_memory.h>
+#include <da/socket/udp_socket.h>
+#include <da/util/status.h>
+
+namespace da {
+namespace transmitter {
+
+// Queues outgoing datagrams and sends them over the socket in batches with a
+// single system call. A full batch of `batch_size` datagrams is flushed right
+// away by the sender that completed it. A partial batch is flushed by
+// `operator()`, which is meant to run on a thread of its own, once `max_delay`
+// has passed since the oldest of its datagrams was queued.
+//
+// The buffers queued for the same peer are packed into frames of at most
+// `max_frame_size` bytes, so a datagram carries as many messages as fit.
+//
+// If `connect_peers` is set then every peer gets a connected socket of its own
+// for sending which spares the kernel a route lookup per datagram.
+//
+// The datagrams to peers on the same host can bypass the socket through the
+// peers' shared memory inboxes.
+class Transmitter {
+ public:
+  Transmitter(socket::UDPSocket* sock);
+
+  Transmitter(socket::UDPSocket* sock, int max_frame_size);
+
+  Transmitter(socket::UDPSocket* sock, bool connect_peers, int max_frame_size);
+
+  Transmitter(socket::UDPSocket* sock, int batch_size,
+              std::chrono::microseconds max_delay);
+
+  Transmitter(socket::UDPSocket* sock, int batch_size,
+              std::chrono::microseconds max_delay, bool connect_peers);
+
+  Transmitter(socket::UDPSocket* sock, int batch_size,
+              std::chrono::microseconds max_delay, bool connect_peers,
+              int max_frame_size);
+
+  ~Transmitter() { stop(); }
+
+  // Delete the copy constructor.
+  Transmitter(const Transmitter&) = delete;
+  // Delete the copy assignment operator.
+  Transmitter& operator=(const Transmitter&) = delete;
+
+  void stop();
+
+  bool isAlive() const { return alive_; }
+
+  // Queues the given buffer to be sent within a UDP datagram to the specified
+  // address/port.
+  util::Status sendTo(const void* buffer, int bufferLen,
+                      const std::string& foreignAddress,
+                      unsigned short foreignPort);
+
+  // Queues the given buffer to be sent within a UDP datagram to the resolved
+  // address.
+  util::Status sendTo(const void* buffer, int bufferLen,
+                      const sockaddr_in& foreignAddr);
+
+  // Delivers the datagrams to the given peer through the outbox whenever
+  // possible and over the socket otherwise.
+  void addSharedMemoryPeer(const sockaddr_in& addr,
+                           std::unique_ptr<shm::Outbox> outbox);
+
+  void operator()();
+
+ private:
+  struct Datagram {
+    std::string data;
+    sockaddr_in addr;
+  };
+
+  // Sends all the given datagrams.
+  void flush(std::vector<Datagram>& datagrams);
+
+  static uint64_t toPeerKey(const sockaddr_in& addr);
+
+  // Returns the connected socket of the given peer or nullptr if the shared
+  // socket has to be used. Assumes that the flush lock is held.
+  socket::UDPSocket* getPeerSocket(const sockaddr_in& addr);
+
+  std::atomic<bool> alive_;
+  socket::UDPSocket* sock_;
+  const int batch_size_;
+  const std::chrono::microseconds max_delay_;
+  const bool connect_peers_;
+  const int max_frame_size_;
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+  std::vector<Datagram> queue_;
+  // Maps every peer to its latest frame in the queue, which the next buffer to
+  // the peer is appended to if it fits.
+  std::unordered_map<uint64_t, int> open_frames_;
+  // Denotes the time at which the oldest datagram in the queue was queued.
+  std::chrono::steady_clock::time_point oldest_;
+  // Denotes whether the flusher is waiting for the queue to be non-empty.
+  bool idle_;
+  // Serializes the flushes. Guards the vectors below which are reused across
+  // flushes so that sending does not allocate.
+  std::mutex flush_mutex_;
+  std::vector<int> order_;
+  std::vector<socket::UDPSocket*> sockets_;
+  std::vector<iovec> iovecs_;
+  std::vector<mmsghdr> headers_;
+  std::unordered_map<uint64_t, std::unique_ptr<socket::UDPSocket>> peers_;
+  std::unordered_map<uint64_t, std::unique_ptr<shm::Outbox>> outboxes_;
+  // The outboxes pushed to by the ongoing flush.
+  std::vector<shm::Outbox*> pushed_outboxes_;
+};
+
+}  // namespace transmitter
+}  // namespace da
+
+#endif  // __INCLUDED_DA_TRANSMITTER_TRANSMITTER_H_
@@ -0,0 +1,78 @@
+#include <da/util/buffer_pool.h>
+
+#include <new>
+#include <utility>
+
+namespace da {
+namespace util {
+
+PooledBuffer::PooledBuffer(const PooledBuffer& buffer)
+    : header_(buffer.header_) {
+  if (header_ != nullptr) {
+    header_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer buffer) noexcept {
+  std::swap(header_, buffer.header_);
+  return *this;
+}
+
+void PooledBuffer::release() {
+  if (header_ == nullptr) {
+    return;
+  }
+  // The last handle hands the buffer back.
+  if (header_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    header_->pool->recycle(header_);
+  }
+  header_ = nullptr;
+}
+
+BufferPool::BufferPool(int buffer_size, int slab_buffers)
+    : buffer_size_(buffer_size),
+      slab_buffers_(slab_buffers),
+      stride_((sizeof(PooledBuffer::Header) + buffer_size +
+               alignof(PooledBuffer::Header) - 1) /
+              alignof(PooledBuffer::Header) *
+              alignof(PooledBuffer::Header)) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  grow();
+}
+
+PooledBuffer BufferPool::acquire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (free_buffers_.empty()) {
+    grow();
+  }
+  PooledBuffer::Header* header = free_buffers_.back();
+  free_buffers_.pop_back();
+  header->refs.store(1, std::memory_order_relaxed);
+  return PooledBuffer(header);
+}
+
+void BufferPool::recycle(PooledBuffer::Header* header) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  free_buffers_.push_back(header);
+}
+
+void BufferPool::grow() {
+  // Over-allocate so that the headers can be aligned.
+  std::unique_ptr<char[]> slab(
+      new char[stride_ * slab_buffers_ + alignof(PooledBuffer::Header)]);
+  void* start = slab.get();
+  std::size_t space = stride_ * slab_buffers_ + alignof(PooledBuffer::Header);
+  std::align(alignof(PooledBuffer::Header), stride_ * slab_buffers_, start,
+             space);
+  char* aligned = static_cast<char*>(start);
+  free_buffers_.reserve(free_buffers_.size() + slab_buffers_);
+  for (int i = slab_buffers_ - 1; i >= 0; i--) {
+    auto header = new (aligned + i * stride_) PooledBuffer::Header;
+    header->pool = this;
+    free_buffers_.push_back(header);
+  }
+  slabs_.push_back(std::move(slab));
+}
+
+}  // namespace util
+}  // namespace da
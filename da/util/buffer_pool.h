@@ -0,0 +1,88 @@
+#ifndef __INCLUDED_DA_UTIL_BUFFER_POOL_H_
+#define __INCLUDED_DA_UTIL_BUFFER_POOL_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace da {
+namespace util {
+
+class BufferPool;
+
+// A reference counted handle to a buffer of a pool. The buffer goes back to
+// its pool once the last handle to it is gone.
+class PooledBuffer {
+ public:
+  PooledBuffer() : header_(nullptr) {}
+
+  PooledBuffer(const PooledBuffer& buffer);
+
+  PooledBuffer(PooledBuffer&& buffer) noexcept : header_(buffer.header_) {
+    buffer.header_ = nullptr;
+  }
+
+  PooledBuffer& operator=(PooledBuffer buffer) noexcept;
+
+  ~PooledBuffer() { release(); }
+
+  char* data() const { return reinterpret_cast<char*>(header_ + 1); }
+
+  explicit operator bool() const { return header_ != nullptr; }
+
+ private:
+  friend class BufferPool;
+
+  // Precedes the bytes of every buffer within a slab.
+  struct alignas(16) Header {
+    std::atomic<int> refs;
+    BufferPool* pool;
+  };
+
+  explicit PooledBuffer(Header* header) : header_(header) {}
+
+  void release();
+
+  Header* header_;
+};
+
+// Hands out buffers of `buffer_size` bytes carved out of slabs of
+// `slab_buffers` buffers each. Acquiring and releasing a buffer does not touch
+// the allocator unless the pool runs dry, in which case it grows by a slab.
+//
+// The pool must outlive all of its buffers.
+class BufferPool {
+ public:
+  BufferPool(int buffer_size, int slab_buffers);
+
+  // Delete the copy constructor.
+  BufferPool(const BufferPool&) = delete;
+  // Delete the copy assignment operator.
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  PooledBuffer acquire();
+
+  int getBufferSize() const { return buffer_size_; }
+
+ private:
+  friend class PooledBuffer;
+
+  void recycle(PooledBuffer::Header* header);
+
+  // Carves out another slab. Assumes that the lock is held.
+  void grow();
+
+  const int buffer_size_;
+  const int slab_buffers_;
+  // Denotes the distance between the headers of two consecutive buffers.
+  const int stride_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<char[]>> slabs_;
+  std::vector<PooledBuffer::Header*> free_buffers_;
+};
+
+}  // namespace util
+}  // namespace da
+
+#endif  // __INCLUDED_DA_UTIL_BUFFER_POOL_H_
@@ -0,0 +1,38 @@
+#ifndef __INCLUDED_DA_UTIL_BYTES_VIEW_H_
+#define __INCLUDED_DA_UTIL_BYTES_VIEW_H_
+
+#include <string>
+
+namespace da {
+namespace util {
+
+// A non-owning view of a contiguous range of bytes, e.g. a received message
+// or a part of it. The bytes must outlive the view.
+class BytesView {
+ public:
+  BytesView() : data_(nullptr), size_(0) {}
+
+  BytesView(const char* data, int size) : data_(data), size_(size) {}
+
+  BytesView(const std::string& str) : data_(str.data()), size_(str.size()) {}
+
+  const char* data() const { return data_; }
+
+  int size() const { return size_; }
+
+  // Returns the view of the bytes following the first `offset` ones.
+  BytesView suffix(int offset) const {
+    return BytesView(data_ + offset, size_ - offset);
+  }
+
+  std::string toString() const { return std::string(data_, size_); }
+
+ private:
+  const char* data_;
+  int size_;
+};
+
+}  // namespace util
+}  // namespace da
+
+#endif  // __INCLUDED_DA_UTIL_BYTES_VIEW_H_
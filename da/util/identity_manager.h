@@ -1,58 +1,209 @@
 #ifndef __INCLUDED_DA_UTIL_IDENTITY_MANAGER_H_
 #define __INCLUDED_DA_UTIL_IDENTITY_MANAGER_H_
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <mutex>
-#include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 
+#include <da/util/status.h>
+
 namespace da {
 namespace util {
 
-template <typename T>
+// Assigns small integer ids to keys and keeps a value along with each of
+// them. An id is held until every assignment of it has been released, after
+// which the key and the value are forgotten and the id is reused for another
+// key.
+//
+// The keys are spread over stripes by their hash, each one with a lock of its
+// own, so that the assignments of different keys rarely contend. The stripe
+// of an id is encoded in its lowest bits. The values are looked up by id
+// without any lock from an array of fixed size chunks that only ever grows.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
 class IdentityManager {
  public:
-  int assignId(const T& t);
+  IdentityManager();
+
+  ~IdentityManager();
+
+  // Delete the copy constructor.
+  IdentityManager(const IdentityManager&) = delete;
+  // Delete the copy assignment operator.
+  IdentityManager& operator=(const IdentityManager&) = delete;
+
+  // Returns the id of the key, which is assigned along with the value if the
+  // key has none. Every call must be paired with a call to `release` once the
+  // id is no longer needed.
+  int assignId(const Key& key, Value value);
 
-  const T* getValue(int id);
+  // Returns the value of the id, or nullptr if the id is not assigned. Does not
+  // take any lock. The value is only valid until the caller releases its
+  // assignment of the id.
+  const Value* getValue(int id) const;
 
-  int getId(const T& t);
+  int getId(const Key& key);
+
+  // Releases an assignment of the given id.
+  void release(int id);
 
  private:
-  std::shared_timed_mutex mutex_;
-  std::unordered_map<T, int> type_to_id_;
-  std::vector<const T*> id_to_type_;
+  static constexpr int num_stripes = 16;
+  static constexpr int chunk_bits = 12;
+  static constexpr int chunk_size = 1 << chunk_bits;
+  // Bounds the number of ids assigned at the same time to 64Mi.
+  static constexpr int max_chunks = 1 << 14;
+
+  struct Entry {
+    int id;
+    Value value;
+  };
+
+  struct Slot {
+    std::atomic<const Value*> value{nullptr};
+    // Guarded by the lock of the stripe of the id.
+    const Key* key = nullptr;
+    // Denotes the number of assignments that have not been released yet.
+    // Guarded by the lock of the stripe of the id.
+    int refs = 0;
+  };
+
+  struct Stripe {
+    std::mutex mutex;
+    std::unordered_map<Key, Entry, Hash> key_to_entry;
+    // The ids of the stripe that have been released and can be assigned
+    // again.
+    std::vector<int> free_ids;
+    // Denotes the number of ids the stripe has ever handed out.
+    int num_ids = 0;
+  };
+
+  Stripe& getStripe(const Key& key);
+
+  // Returns the slot of the id, allocating its chunk if need be. Assumes that
+  // the lock of the stripe of the id is held.
+  Slot& getOrCreateSlot(int id);
+
+  Hash hash_;
+  Stripe stripes_[num_stripes];
+  // Chunks are published once and freed along with the manager.
+  std::atomic<Slot*> chunks_[max_chunks];
 };
 
-template <typename T>
-int IdentityManager<T>::assignId(const T& t) {
-  std::unique_lock<std::shared_timed_mutex> lock(mutex_);
-  if (type_to_id_.find(t) != type_to_id_.end()) {
-    return type_to_id_[t];
+template <typename Key, typename Value, typename Hash>
+IdentityManager<Key, Value, Hash>::IdentityManager() {
+  for (auto& chunk : chunks_) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+IdentityManager<Key, Value, Hash>::~IdentityManager() {
+  for (auto& chunk : chunks_) {
+    delete[] chunk.load(std::memory_order_relaxed);
   }
-  int id = id_to_type_.size();
-  type_to_id_[t] = id;
-  const T* t_ptr = &(type_to_id_.find(t)->first);
-  id_to_type_.push_back(t_ptr);
+}
+
+template <typename Key, typename Value, typename Hash>
+int IdentityManager<Key, Value, Hash>::assignId(const Key& key, Value value) {
+  Stripe& stripe = getStripe(key);
+  std::unique_lock<std::mutex> lock(stripe.mutex);
+  const auto it = stripe.key_to_entry.find(key);
+  if (it != stripe.key_to_entry.end()) {
+    getOrCreateSlot(it->second.id).refs += 1;
+    return it->second.id;
+  }
+  int id;
+  if (stripe.free_ids.empty()) {
+    id = stripe.num_ids * num_stripes + int(&stripe - stripes_);
+    stripe.num_ids += 1;
+  } else {
+    id = stripe.free_ids.back();
+    stripe.free_ids.pop_back();
+  }
+  Slot& slot = getOrCreateSlot(id);
+  const auto node =
+      stripe.key_to_entry.emplace(key, Entry{id, std::move(value)}).first;
+  slot.key = &node->first;
+  slot.refs = 1;
+  // Publish the value to the readers.
+  slot.value.store(&node->second.value, std::memory_order_release);
   return id;
 }
 
-template <typename T>
-const T* IdentityManager<T>::getValue(int id) {
-  std::shared_lock<std::shared_timed_mutex> lock(mutex_);
-  if (id >= int(id_to_type_.size())) {
+template <typename Key, typename Value, typename Hash>
+const Value* IdentityManager<Key, Value, Hash>::getValue(int id) const {
+  if (id < 0 || (id >> chunk_bits) >= max_chunks) {
+    return nullptr;
+  }
+  const Slot* chunk =
+      chunks_[id >> chunk_bits].load(std::memory_order_acquire);
+  if (chunk == nullptr) {
     return nullptr;
   }
-  return id_to_type_[id];
+  return chunk[id & (chunk_size - 1)].value.load(std::memory_order_acquire);
 }
 
-template <typename T>
-int IdentityManager<T>::getId(const T& t) {
-  std::shared_lock<std::shared_timed_mutex> lock(mutex_);
-  if (type_to_id_.find(t) == type_to_id_.end()) {
+template <typename Key, typename Value, typename Hash>
+int IdentityManager<Key, Value, Hash>::getId(const Key& key) {
+  Stripe& stripe = getStripe(key);
+  std::unique_lock<std::mutex> lock(stripe.mutex);
+  const auto it = stripe.key_to_entry.find(key);
+  if (it == stripe.key_to_entry.end()) {
     return -1;
   }
-  return type_to_id_[t];
+  return it->second.id;
+}
+
+template <typename Key, typename Value, typename Hash>
+void IdentityManager<Key, Value, Hash>::release(int id) {
+  if (getValue(id) == nullptr) {
+    return;
+  }
+  Stripe& stripe = stripes_[id % num_stripes];
+  std::unique_lock<std::mutex> lock(stripe.mutex);
+  Slot& slot = getOrCreateSlot(id);
+  if (slot.key == nullptr) {
+    return;
+  }
+  slot.refs -= 1;
+  if (slot.refs > 0) {
+    return;
+  }
+  slot.value.store(nullptr, std::memory_order_release);
+  stripe.key_to_entry.erase(*slot.key);
+  slot.key = nullptr;
+  stripe.free_ids.push_back(id);
+}
+
+template <typename Key, typename Value, typename Hash>
+typename IdentityManager<Key, Value, Hash>::Stripe&
+IdentityManager<Key, Value, Hash>::getStripe(const Key& key) {
+  return stripes_[hash_(key) % num_stripes];
+}
+
+template <typename Key, typename Value, typename Hash>
+typename IdentityManager<Key, Value, Hash>::Slot&
+IdentityManager<Key, Value, Hash>::getOrCreateSlot(int id) {
+  if ((id >> chunk_bits) >= max_chunks) {
+    throw RuntimeStatusError(Status(StatusCode::kResourceExhausted,
+                                    "Ran out of ids to assign"));
+  }
+  auto& chunk = chunks_[id >> chunk_bits];
+  Slot* slots = chunk.load(std::memory_order_acquire);
+  if (slots == nullptr) {
+    // The stripes share the chunks and might race to allocate the same one.
+    Slot* fresh = new Slot[chunk_size];
+    if (chunk.compare_exchange_strong(slots, fresh,
+                                      std::memory_order_acq_rel)) {
+      slots = fresh;
+    } else {
+      delete[] fresh;
+    }
+  }
+  return slots[id & (chunk_size - 1)];
 }
 
 }  // namespace util
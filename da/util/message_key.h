@@ -0,0 +1,53 @@
+#ifndef __INCLUDED_DA_UTIL_MESSAGE_KEY_H_
+#define __INCLUDED_DA_UTIL_MESSAGE_KEY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace da {
+namespace util {
+
+// Denotes the layer of the stack that a message is identified at.
+enum class Layer : uint8_t {
+  kLink = 0,
+  kUniformReliable = 1,
+  kFIFO = 2,
+  kLocalizedCausal = 3,
+};
+
+// Identifies a message by the process that broadcasted it and the sequence
+// number that process assigned to it, instead of by its bytes.
+struct MessageKey {
+  uint16_t origin;
+  Layer layer;
+  uint32_t seq;
+};
+
+static_assert(sizeof(MessageKey) == 8, "MessageKey must fit in 8 bytes");
+
+inline bool operator==(const MessageKey& lhs, const MessageKey& rhs) {
+  return lhs.origin == rhs.origin && lhs.layer == rhs.layer &&
+         lhs.seq == rhs.seq;
+}
+
+inline bool operator!=(const MessageKey& lhs, const MessageKey& rhs) {
+  return !(lhs == rhs);
+}
+
+// Packs the key into a single integer and mixes its bits so that the
+// consecutive sequence numbers of an origin spread over the buckets.
+struct MessageKeyHash {
+  std::size_t operator()(const MessageKey& key) const {
+    uint64_t x = (uint64_t(key.origin) << 40) | (uint64_t(key.layer) << 32) |
+                 key.seq;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+  }
+};
+
+}  // namespace util
+}  // namespace da
+
+#endif  // __INCLUDED_DA_UTIL_MESSAGE_KEY_H_
@@ -0,0 +1,61 @@
+#include <da/util/sequence_window.h>
+
+namespace da {
+namespace util {
+namespace {
+
+const int word_bits = 64;
+
+}  // namespace
+
+bool SequenceWindow::insert(uint64_t seq) {
+  if (seq < low_ || seq - low_ >= max_span) {
+    return false;
+  }
+  const uint64_t index = (seq - base_) / word_bits;
+  const uint64_t bit = uint64_t(1) << ((seq - base_) % word_bits);
+  if (index >= words_.size()) {
+    words_.resize(index + 1, 0);
+  }
+  if (words_[index] & bit) {
+    return false;
+  }
+  words_[index] |= bit;
+  if (seq != low_) {
+    return true;
+  }
+  // Drop the words that are full and move the watermark to the first number
+  // that is missing.
+  while (!words_.empty() && words_.front() == ~uint64_t(0)) {
+    words_.pop_front();
+    base_ += word_bits;
+  }
+  low_ = words_.empty() ? base_ : base_ + __builtin_ctzll(~words_.front());
+  return true;
+}
+
+bool SequenceWindow::contains(uint64_t seq) const {
+  if (seq < low_) {
+    return true;
+  }
+  return getWord((seq - base_) / word_bits) &
+         (uint64_t(1) << ((seq - base_) % word_bits));
+}
+
+uint64_t SequenceWindow::getBitmapAfterLowWatermark() const {
+  const uint64_t offset = low_ + 1 - base_;
+  const uint64_t index = offset / word_bits;
+  const int shift = offset % word_bits;
+  uint64_t bitmap = getWord(index) >> shift;
+  if (shift > 0) {
+    bitmap |= getWord(index + 1) << (word_bits - shift);
+  }
+  return bitmap;
+}
+
+uint64_t SequenceWindow::getWord(uint64_t index) const {
+  return index < words_.size() ? words_[index] : 0;
+}
+
+}  // namespace util
+}  // namespace da
@@ -0,0 +1,54 @@
+#ifndef __INCLUDED_DA_UTIL_SEQUENCE_WINDOW_H_
+#define __INCLUDED_DA_UTIL_SEQUENCE_WINDOW_H_
+
+#include <cstdint>
+#include <deque>
+
+namespace da {
+namespace util {
+
+// Tracks which numbers of a sequence have been seen. All the numbers below the
+// low watermark have been seen and the ones seen above it are kept in a
+// bitmap. The memory is hence, proportional to the span of the numbers seen
+// out of order rather than to the length of the sequence, which is bounded by
+// ignoring the numbers that are too far past the low watermark.
+//
+// The window is not thread-safe.
+class SequenceWindow {
+ public:
+  // Denotes how far past the low watermark the numbers are recorded, which
+  // bounds the bitmap to 64 KiB.
+  static constexpr uint64_t max_span = uint64_t(1) << 19;
+
+  SequenceWindow() : low_(0), base_(0) {}
+
+  // Records the number. Returns whether it is seen for the first time. A
+  // number at least `max_span` past the low watermark is not recorded and
+  // false is returned.
+  bool insert(uint64_t seq);
+
+  bool contains(uint64_t seq) const;
+
+  // Returns the first number that has not been seen.
+  uint64_t getLowWatermark() const { return low_; }
+
+  // Returns the bitmap of the 64 numbers following the low watermark in which
+  // the i-th bit denotes whether `low watermark + 1 + i` has been seen.
+  uint64_t getBitmapAfterLowWatermark() const;
+
+ private:
+  // Returns the word of the bitmap at the given index or zero if it is past
+  // the end.
+  uint64_t getWord(uint64_t index) const;
+
+  uint64_t low_;
+  // Denotes the number the first word of the bitmap starts at. A multiple of
+  // 64 that is at most the low watermark.
+  uint64_t base_;
+  std::deque<uint64_t> words_;
+};
+
+}  // namespace util
+}  // namespace da
+
+#endif  // __INCLUDED_DA_UTIL_SEQUENCE_WINDOW_H_
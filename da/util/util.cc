@@ -35,9 +35,13 @@ void nanosleep(uint64_t time) {
 }
 
 std::string stringToBinary(const std::string* str) {
+  return stringToBinary(BytesView(*str));
+}
+
+std::string stringToBinary(const BytesView& bytes) {
   std::string binary = "";
-  for (const auto& c : *str) {
-    binary += std::bitset<8>(c).to_string();
+  for (int i = 0; i < bytes.size(); i++) {
+    binary += std::bitset<8>(bytes.data()[i]).to_string();
   }
   return binary;
 }
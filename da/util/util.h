@@ -4,6 +4,8 @@
 #include <unistd.h>
 #include <string>
 
+#include <da/util/bytes_view.h>
+
 namespace da {
 namespace util {
 
@@ -45,6 +47,8 @@ void nanosleep(uint64_t time);
 
 std::string stringToBinary(const std::string* str);
 
+std::string stringToBinary(const BytesView& bytes);
+
 }  // namespace util
 }  // namespace da
 
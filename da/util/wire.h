@@ -0,0 +1,95 @@
+#ifndef __INCLUDED_DA_UTIL_WIRE_H_
+#define __INCLUDED_DA_UTIL_WIRE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace da {
+namespace util {
+namespace internal {
+
+inline uint8_t byteSwap(uint8_t x) { return x; }
+
+inline uint16_t byteSwap(uint16_t x) { return __builtin_bswap16(x); }
+
+inline uint32_t byteSwap(uint32_t x) { return __builtin_bswap32(x); }
+
+inline uint64_t byteSwap(uint64_t x) { return __builtin_bswap64(x); }
+
+// Converts between the host and the network byte order.
+template <typename T>
+T toNetworkOrder(T x) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  return byteSwap(x);
+#else
+  return x;
+#endif
+}
+
+}  // namespace internal
+
+// Reads the integer stored in network byte order at the given, possibly
+// unaligned, address.
+template <typename T>
+T loadBigEndian(const char* buffer) {
+  static_assert(std::is_integral<T>::value, "Only integers can be loaded");
+  typename std::make_unsigned<T>::type x;
+  memcpy(&x, buffer, sizeof(x));
+  return static_cast<T>(internal::toNetworkOrder(x));
+}
+
+// Writes the integer in network byte order at the given, possibly unaligned,
+// address.
+template <typename T>
+void storeBigEndian(char* buffer, T x) {
+  static_assert(std::is_integral<T>::value, "Only integers can be stored");
+  const auto y = internal::toNetworkOrder(
+      static_cast<typename std::make_unsigned<T>::type>(x));
+  memcpy(buffer, &y, sizeof(y));
+}
+
+// Describes an integer field at a fixed offset of a packed wire header. A
+// header is laid out by chaining its fields, each one starting at the `end` of
+// the previous one, so that all the offsets are known at compile time.
+template <typename T, int Offset>
+struct Field {
+  using Type = T;
+
+  static constexpr int offset = Offset;
+  // Denotes the offset right past the field.
+  static constexpr int end = Offset + sizeof(T);
+
+  static T load(const char* header) {
+    return loadBigEndian<T>(header + Offset);
+  }
+
+  static void store(char* header, T x) {
+    storeBigEndian<T>(header + Offset, x);
+  }
+};
+
+// Describes an array of integer fields starting at a fixed offset of a packed
+// wire header, whose length is only known at runtime.
+template <typename T, int Offset>
+struct ArrayField {
+  using Type = T;
+
+  static constexpr int offset = Offset;
+
+  // Returns the offset right past an array of `count` fields.
+  static constexpr int getEnd(int count) { return Offset + count * sizeof(T); }
+
+  static T load(const char* header, int i) {
+    return loadBigEndian<T>(header + Offset + i * sizeof(T));
+  }
+
+  static void store(char* header, int i, T x) {
+    storeBigEndian<T>(header + Offset + i * sizeof(T), x);
+  }
+};
+
+}  // namespace util
+}  // namespace da
+
+#endif  // __INCLUDED_DA_UTIL_WIRE_H_